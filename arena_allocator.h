@@ -0,0 +1,223 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef HASHCOL_ARENA_ALLOCATOR_H
+#define HASHCOL_ARENA_ALLOCATOR_H
+
+#include <cstddef>
+#include <climits>
+#include <new>
+#include "config.h"
+#include "bit_ops.h"
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+/**********************************************************************************
+
+NOTES:
+
+  - An arena hands out memory from large chunks and never gives it back 
+  before it is destroyed. Freed blocks are kept on lists by size class (four
+  per power of two, so rounding wastes at most a quarter) and handed out 
+  again for requests of the same class: the slots a table drops on clear() 
+  or growth are reused by the next table of that size, instead of going 
+  back and forth to the system.
+
+  - Containers construct their allocators themselves, so arena_allocator 
+  finds its arena by type: each tag_t has one, made on first use. Tables 
+  that should share buffers use the same tag. Allocators made from an arena
+  explicitly use that one (e.g. for standard containers).
+
+  - Arenas are not thread safe. Tables used from several threads at once 
+  need a tag of their own each.
+
+***********************************************************************************/
+
+class arena
+{
+public:
+  explicit arena(std::size_t chunk_size = 1 << 20):
+    chunk_size_(chunk_size),chunks_(0),current_(0),left_(0)
+  {
+    for (std::size_t i = 0; i != CLASSES; ++i) this->free_[i] = 0;
+  }
+  ~arena(){this->release();}
+
+  void* allocate(std::size_t bytes)
+  {
+    std::size_t size;
+    std::size_t c = size_class(bytes, size);
+    if (this->free_[c] != 0)
+    {
+      Block* b = this->free_[c];
+      this->free_[c] = b->next_;
+      return b;
+    }
+    if (size > this->left_)
+    {
+      if (size > this->chunk_size_ / 4) return this->new_chunk(size); //Its own chunk.
+      this->current_ = static_cast<char*>(this->new_chunk(this->chunk_size_));
+      this->left_ = this->chunk_size_;
+    }
+    void* p = this->current_;
+    this->current_ += size;
+    this->left_ -= size;
+    return p;
+  }
+  //p goes back on its free list, for the next request of its size class.
+  void deallocate(void* p, std::size_t bytes)
+  {
+    std::size_t size;
+    std::size_t c = size_class(bytes, size);
+    Block* b = static_cast<Block*>(p);
+    b->next_ = this->free_[c];
+    this->free_[c] = b;
+  }
+  //Gives all the memory back. Whatever was allocated is gone.
+  void release()
+  {
+    while (this->chunks_ != 0)
+    {
+      Chunk* next = this->chunks_->next_;
+      ::operator delete(this->chunks_);
+      this->chunks_ = next;
+    }
+    for (std::size_t i = 0; i != CLASSES; ++i) this->free_[i] = 0;
+    this->current_ = 0;
+    this->left_ = 0;
+  }
+
+  //The arena of arena_allocator<T, tag_t>.
+  template <class tag_t>
+  static arena& instance()
+  {
+    static arena a;
+    return a;
+  }
+
+private:
+  enum {ALIGNMENT = 16, CLASSES = 4 * sizeof(std::size_t) * CHAR_BIT};
+
+  struct Block
+  {
+    Block* next_;
+  };
+  struct Chunk
+  {
+    Chunk* next_;
+  };
+
+  std::size_t chunk_size_;
+  Chunk* chunks_;
+  char* current_;
+  std::size_t left_;
+  Block* free_[CLASSES];
+
+  arena(const arena&);
+  arena& operator=(const arena&);
+
+  void* new_chunk(std::size_t size)
+  {
+    std::size_t header = (sizeof(Chunk*) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    Chunk* c = static_cast<Chunk*>(::operator new(header + size));
+    c->next_ = this->chunks_;
+    this->chunks_ = c;
+    return reinterpret_cast<char*>(c) + header;
+  }
+  //Size classes split (2^k, 2^(k+1)] in four. size is what a block of the 
+  //class takes.
+  static std::size_t size_class(std::size_t bytes, std::size_t& size)
+  {
+    if (bytes < 4 * ALIGNMENT) bytes = 4 * ALIGNMENT;
+    std::size_t half = next_power_of_two(bytes) / 2;
+    std::size_t step = half / 4;
+    std::size_t j = (bytes - half - 1) / step + 1;
+    size = (half + j * step + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    return 4 * count_trailing_zeros(half) + j - 1;
+  }
+};
+
+struct default_arena_tag{};
+
+//Allocator on an arena, by default the one of tag_t.
+template <class T, class tag_t = default_arena_tag>
+class arena_allocator
+{
+public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+  template <class U>
+  struct rebind
+  {
+    typedef arena_allocator<U, tag_t> other;
+  };
+
+  arena_allocator():arena_(&arena::instance<tag_t>()){}
+  explicit arena_allocator(arena& a):arena_(&a){}
+  template <class U>
+  arena_allocator(const arena_allocator<U, tag_t>& other):arena_(other.arena_){}
+
+  pointer allocate(size_type n, const void* = 0)
+  {
+    return static_cast<pointer>(this->arena_->allocate(n * sizeof(T)));
+  }
+  void deallocate(pointer p, size_type n){this->arena_->deallocate(p, n * sizeof(T));}
+  size_type max_size()const{return size_type(-1) / sizeof(T);}
+#ifndef HASHCOL_HAS_CXX11
+  //Construction is left to std::allocator_traits otherwise.
+  pointer address(reference x)const{return &x;}
+  const_pointer address(const_reference x)const{return &x;}
+  void construct(pointer p, const T& x){new (p) T(x);}
+  void destroy(pointer p){p->~T();}
+#endif
+
+  arena* arena_;
+};
+
+template <class T, class U, class tag_t>
+inline bool operator==(const arena_allocator<T, tag_t>& l, const arena_allocator<U, tag_t>& r)
+{
+  return l.arena_ == r.arena_;
+}
+template <class T, class U, class tag_t>
+inline bool operator!=(const arena_allocator<T, tag_t>& l, const arena_allocator<U, tag_t>& r)
+{
+  return l.arena_ != r.arena_;
+}
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_ARENA_ALLOCATOR_H
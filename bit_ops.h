@@ -0,0 +1,107 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef HASHCOL_BIT_OPS_H
+#define HASHCOL_BIT_OPS_H
+
+#include <cstddef>
+#include <climits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "config.h"
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+//Index of the lowest set bit. The argument must not be zero.
+inline unsigned count_trailing_zeros(std::size_t x)
+{
+#if defined(__GNUC__)
+  return sizeof(std::size_t) == sizeof(unsigned long) ?
+    __builtin_ctzl(x) : __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_WIN64)
+  unsigned long index;
+  _BitScanForward64(&index, x);
+  return index;
+#elif defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, x);
+  return index;
+#else
+  unsigned n = 0;
+  for (; !(x & 1); x >>= 1) ++n;
+  return n;
+#endif
+}
+
+//Number of set bits.
+inline unsigned population_count(std::size_t x)
+{
+#if defined(__GNUC__)
+  return sizeof(std::size_t) == sizeof(unsigned long) ?
+    __builtin_popcountl(x) : __builtin_popcountll(x);
+#else
+  unsigned n = 0;
+  for (; x; x &= x - 1) ++n;
+  return n;
+#endif
+}
+
+//Smallest power of two not less than x (and not less than 1).
+inline std::size_t next_power_of_two(std::size_t x)
+{
+  std::size_t p = 1;
+  while (p < x) p <<= 1;
+  return p;
+}
+
+inline bool is_power_of_two(std::size_t x)
+{
+  return x != 0 && (x & (x - 1)) == 0;
+}
+
+//Hint that the cache line holding p is about to be read. No effect where 
+//the compiler offers no way to say so.
+inline void prefetch(const void* p)
+{
+#if defined(__GNUC__)
+  __builtin_prefetch(p);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+  (void)p;
+#endif
+}
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_BIT_OPS_H
@@ -0,0 +1,252 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef HASHCOL_COMPACT_HASH_MULTIMAP_H
+#define HASHCOL_COMPACT_HASH_MULTIMAP_H
+
+
+#include <vector>
+#include "hash_table.h"
+#include "increment.h"
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+/**********************************************************************************
+
+NOTES:
+
+  - A hash_multimap that keeps each distinct key once, with all its values 
+  in one vector (value_list). However many values a key has, it takes one 
+  slot, so skewed data does not cluster the table, count() and erase() are a
+  single lookup, and the values of a key are contiguous.
+
+  - Iteration is over entries, pairs of a key and its value list. size() 
+  counts values; distinct_size() counts keys. The values of a key stay in 
+  insertion order. Entries are read-only: values are added by insert() and
+  removed by erase(), which keep size() up to date.
+
+***********************************************************************************/
+
+template <
+  class key_t, 
+  class value_t, 
+  class hash_fcn_t = hash<key_t>, 
+  class increment_t = unit_increment<key_t>,
+  class equal_key_t = std::equal_to<key_t>, 
+  class alloc_t = std::allocator<std::pair<key_t, value_t> >,
+  class growth_t = modulo_growth>
+class compact_hash_multimap 
+{
+private:
+  typedef compact_hash_multimap<key_t, value_t, hash_fcn_t, increment_t, equal_key_t, alloc_t, growth_t> Self;
+
+  typedef std::vector<value_t, typename rebind_alloc__<alloc_t, value_t>::type> List;
+  typedef std::pair<key_t, List> Entry;
+  typedef hash_table__<
+    key_t,
+    Entry,
+    hash_fcn_t,
+    increment_t,
+    equal_key_t,
+    select1st<Entry>,
+    alloc_t,
+    growth_t> HT; 
+
+  typedef typename HT::iterator Position;
+
+  HT underlying_;
+  std::size_t size_; //Values, all keys together.
+
+  struct NewEntry
+  {
+    Entry operator()(const key_t& k)const{return Entry(k, List());}
+  };
+
+public:
+  typedef typename HT::key_type key_type;
+  typedef value_t data_type;
+  typedef std::pair<key_t, value_t> value_type;
+  typedef List value_list;
+  typedef Entry entry_type;
+  typedef typename HT::size_type size_type;
+  typedef typename HT::hasher hasher;
+  typedef typename HT::key_equal key_equal;
+  typedef typename HT::allocator allocator;
+  typedef typename HT::const_iterator iterator;
+  typedef typename HT::const_iterator const_iterator;
+  typedef typename HT::difference_type difference_type;
+  
+  compact_hash_multimap(size_type max = 100):
+    underlying_(max),size_(0){}
+  compact_hash_multimap(size_type max, const hasher& h):
+    underlying_(max, h),size_(0){}
+  compact_hash_multimap(size_type max, const hasher& h, const key_equal& eq):
+    underlying_(max, h, eq),size_(0){}
+
+  template <class input_iterator_t>
+  compact_hash_multimap(input_iterator_t b, input_iterator_t e, size_type max = 100):
+    underlying_(max),size_(0)
+  {
+    this->insert(b, e);
+  }
+  template <class input_iterator_t>
+  compact_hash_multimap(input_iterator_t b, input_iterator_t e, size_type max, const hasher& h):
+    underlying_(max, h),size_(0)
+  {
+    this->insert(b, e);
+  }
+  template <class input_iterator_t>
+  compact_hash_multimap(input_iterator_t b, input_iterator_t e, size_type max, const hasher& h, const key_equal& eq):
+    underlying_(max, h, eq),size_(0)
+  {
+    this->insert(b, e);
+  }
+
+  //Getters.
+  hasher hash_funct()const{return this->underlying_.hash_funct();}
+  key_equal key_eq()const{return this->underlying_.key_eq();}
+
+  void swap(Self& other)
+  {
+    this->underlying_.swap(other.underlying_);
+    std::swap(this->size_, other.size_);
+  }
+
+  //Appends x.second to the values of x.first. Returns its entry.
+  iterator insert(const value_type& x)
+  {
+    Position it = this->underlying_.insert_unique_key(x.first, NewEntry()).first;
+    it->second.push_back(x.second);
+    ++this->size_;
+    return it;
+  }
+#ifdef HASHCOL_HAS_CXX11
+  iterator insert(value_type&& x)
+  {
+    Position it = this->underlying_.insert_unique_key(x.first, NewEntry()).first;
+    it->second.push_back(std::move(x.second));
+    ++this->size_;
+    return it;
+  }
+  template <class... args_t>
+  iterator emplace(const key_type& k, args_t&&... args)
+  {
+    Position it = this->underlying_.insert_unique_key(k, NewEntry()).first;
+    it->second.emplace_back(std::forward<args_t>(args)...);
+    ++this->size_;
+    return it;
+  }
+#endif  
+  template <class iterator_t>
+  void insert(iterator_t b, iterator_t e)
+  {
+    for (; b != e; ++b) this->insert(*b);
+  }
+
+  //Erases the entry, all values of its key.
+  void erase(iterator it)
+  {
+    this->size_ -= it->second.size();
+    this->underlying_.erase(it);
+  }
+  size_type erase(const key_type& k)
+  {
+    Position it = this->underlying_.find(k);
+    if (it == this->underlying_.end()) return 0;
+    size_type n = it->second.size();
+    this->erase(it);
+    return n;
+  }
+  //Erases up to n values of k, the last inserted first. Returns how many 
+  //there were.
+  size_type erase(const key_type& k, size_type n)
+  {
+    Position it = this->underlying_.find(k);
+    if (it == this->underlying_.end()) return 0;
+    if (it->second.size() <= n) 
+    {
+      n = it->second.size();
+      this->erase(it);
+      return n;
+    }
+    it->second.erase(it->second.end() - n, it->second.end());
+    this->size_ -= n;
+    return n;
+  }
+
+  iterator find(const key_type& k){return this->underlying_.find(k);}
+  const_iterator find(const key_type& k)const{return this->underlying_.find(k);}
+  size_type count(const key_type& k)const
+  {
+    const_iterator it = this->underlying_.find(k);
+    return it == this->underlying_.end() ? 0 : it->second.size();
+  }
+
+  size_type size()const{return this->size_;}
+  size_type distinct_size()const{return this->underlying_.size();}
+  size_type max_size()const{return this->underlying_.max_size();}
+  size_type bucket_count()const{return this->underlying_.bucket_count();}
+  bool empty()const{return this->underlying_.empty();}
+  void resize(size_type n){this->underlying_.resize(n);}
+  void clear()
+  {
+    this->underlying_.clear();
+    this->size_ = 0;
+  }
+  void compact(){this->underlying_.compact();}
+  float load_factor()const{return this->underlying_.load_factor();}
+  float max_load_factor()const{return this->underlying_.max_load_factor();}
+  void max_load_factor(float z){this->underlying_.max_load_factor(z);}
+  //Room for n distinct keys.
+  void reserve(size_type n){this->underlying_.reserve(n);}
+  void rehash(size_type n){this->underlying_.rehash(n);}
+  table_statistics statistics()const{return this->underlying_.statistics();}
+
+  iterator begin(){return this->underlying_.begin();}
+  iterator end(){return this->underlying_.end();}
+  const_iterator begin()const{return this->underlying_.begin();}
+  const_iterator end()const{return this->underlying_.end();}
+
+  template <class K, class V, class H, class I, class E, class A, class P>
+  friend bool
+  operator==(const compact_hash_multimap<K, V, H, I, E, A, P>& l, const compact_hash_multimap<K, V, H, I, E, A, P>& r);
+};
+
+//Values of a key compare in order.
+template <class K, class V, class H, class I, class E, class A, class P>
+bool
+operator==(const compact_hash_multimap<K, V, H, I, E, A, P>& l, const compact_hash_multimap<K, V, H, I, E, A, P>& r)
+{
+  return l.size_ == r.size_ && l.underlying_ == r.underlying_;
+}
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_COMPACT_HASH_MULTIMAP_H
@@ -0,0 +1,240 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef HASHCOL_COMPACT_HASH_MULTISET_H
+#define HASHCOL_COMPACT_HASH_MULTISET_H
+
+
+#include <limits>
+#include "hash_table.h"
+#include "increment.h"
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+/**********************************************************************************
+
+NOTES:
+
+  - A hash_multiset that keeps each distinct value once, with how many times
+  it is there. Copies of a value take no slots of their own, so skewed data 
+  does not fill the table with clusters of equal keys, and count() and 
+  erase() are a single lookup.
+
+  - Iteration is over entries, pairs of a value and its count, rather than 
+  over every copy. size() counts copies; distinct_size() counts entries.
+  Entries are read-only: counts change through insert() and erase(), which
+  keep size() up to date.
+
+***********************************************************************************/
+
+template <
+  class value_t, 
+  class hash_fcn_t = hash<value_t>, 
+  class increment_t = unit_increment<value_t>,
+  class equal_key_t = std::equal_to<value_t>, 
+  class alloc_t = std::allocator<value_t>,
+  class growth_t = modulo_growth>
+class compact_hash_multiset 
+{
+private:
+  typedef compact_hash_multiset<value_t, hash_fcn_t, increment_t, equal_key_t, alloc_t, growth_t> Self;
+
+  typedef std::pair<value_t, std::size_t> Entry;
+  typedef hash_table__<
+    value_t,
+    Entry,
+    hash_fcn_t,
+    increment_t,
+    equal_key_t,
+    select1st<Entry>,
+    alloc_t,
+    growth_t> HT; 
+
+  typedef typename HT::iterator Position;
+
+  HT underlying_;
+  std::size_t size_; //Copies, all entries together.
+
+  struct NewEntry
+  {
+    Entry operator()(const value_t& x)const{return Entry(x, 0);}
+  };
+
+  //insert(x, n) with integers of the same type matches insert(b, e).
+  template <bool> struct Integral{};
+  template <class iterator_t>
+  void insert_range(iterator_t x, iterator_t n, Integral<true>){this->insert(value_type(x), size_type(n));}
+  template <class iterator_t>
+  void insert_range(iterator_t b, iterator_t e, Integral<false>)
+  {
+    for (; b != e; ++b) this->insert(*b);
+  }
+
+public:
+  typedef typename HT::key_type key_type;
+  typedef value_t value_type;
+  typedef Entry entry_type;
+  typedef typename HT::size_type size_type;
+  typedef typename HT::hasher hasher;
+  typedef typename HT::key_equal key_equal;
+  typedef typename HT::allocator allocator;
+  typedef typename HT::const_iterator iterator;
+  typedef typename HT::const_iterator const_iterator;
+  typedef typename HT::difference_type difference_type;
+  
+  compact_hash_multiset(size_type max = 100):
+    underlying_(max),size_(0){}
+  compact_hash_multiset(size_type max, const hasher& h):
+    underlying_(max, h),size_(0){}
+  compact_hash_multiset(size_type max, const hasher& h, const key_equal& eq):
+    underlying_(max, h, eq),size_(0){}
+
+  template <class input_iterator_t>
+  compact_hash_multiset(input_iterator_t b, input_iterator_t e, size_type max = 100):
+    underlying_(max),size_(0)
+  {
+    this->insert(b, e);
+  }
+  template <class input_iterator_t>
+  compact_hash_multiset(input_iterator_t b, input_iterator_t e, size_type max, const hasher& h):
+    underlying_(max, h),size_(0)
+  {
+    this->insert(b, e);
+  }
+  template <class input_iterator_t>
+  compact_hash_multiset(input_iterator_t b, input_iterator_t e, size_type max, const hasher& h, const key_equal& eq):
+    underlying_(max, h, eq),size_(0)
+  {
+    this->insert(b, e);
+  }
+
+  //Getters.
+  hasher hash_funct()const{return this->underlying_.hash_funct();}
+  key_equal key_eq()const{return this->underlying_.key_eq();}
+
+  void swap(Self& other)
+  {
+    this->underlying_.swap(other.underlying_);
+    std::swap(this->size_, other.size_);
+  }
+
+  //Adds n copies of x. Returns its entry (end() if n is 0 and there is no x).
+  iterator insert(const value_type& x, size_type n = 1)
+  {
+    if (n == 0) return this->find(x);
+    Position it = this->underlying_.insert_unique_key(x, NewEntry()).first;
+    it->second += n;
+    this->size_ += n;
+    return it;
+  }
+  template <class iterator_t>
+  void insert(iterator_t b, iterator_t e)
+  {
+    this->insert_range(b, e, Integral<std::numeric_limits<iterator_t>::is_integer>());
+  }
+
+  //Erases the entry, all copies.
+  void erase(iterator it)
+  {
+    this->size_ -= it->second;
+    this->underlying_.erase(it);
+  }
+  size_type erase(const key_type& k)
+  {
+    Position it = this->underlying_.find(k);
+    if (it == this->underlying_.end()) return 0;
+    size_type n = it->second;
+    this->erase(it);
+    return n;
+  }
+  //Erases up to n copies of k. Returns how many there were.
+  size_type erase(const key_type& k, size_type n)
+  {
+    Position it = this->underlying_.find(k);
+    if (it == this->underlying_.end()) return 0;
+    if (it->second <= n) 
+    {
+      n = it->second;
+      this->erase(it);
+      return n;
+    }
+    it->second -= n;
+    this->size_ -= n;
+    return n;
+  }
+
+  iterator find(const key_type& k){return this->underlying_.find(k);}
+  const_iterator find(const key_type& k)const{return this->underlying_.find(k);}
+  size_type count(const key_type& k)const
+  {
+    const_iterator it = this->underlying_.find(k);
+    return it == this->underlying_.end() ? 0 : it->second;
+  }
+
+  size_type size()const{return this->size_;}
+  size_type distinct_size()const{return this->underlying_.size();}
+  size_type max_size()const{return this->underlying_.max_size();}
+  size_type bucket_count()const{return this->underlying_.bucket_count();}
+  bool empty()const{return this->underlying_.empty();}
+  void resize(size_type n){this->underlying_.resize(n);}
+  void clear()
+  {
+    this->underlying_.clear();
+    this->size_ = 0;
+  }
+  void compact(){this->underlying_.compact();}
+  float load_factor()const{return this->underlying_.load_factor();}
+  float max_load_factor()const{return this->underlying_.max_load_factor();}
+  void max_load_factor(float z){this->underlying_.max_load_factor(z);}
+  //Room for n distinct values.
+  void reserve(size_type n){this->underlying_.reserve(n);}
+  void rehash(size_type n){this->underlying_.rehash(n);}
+  table_statistics statistics()const{return this->underlying_.statistics();}
+
+  iterator begin(){return this->underlying_.begin();}
+  iterator end(){return this->underlying_.end();}
+  const_iterator begin()const{return this->underlying_.begin();}
+  const_iterator end()const{return this->underlying_.end();}
+
+  template <class V, class H, class I, class E, class A, class P>
+  friend bool
+  operator==(const compact_hash_multiset<V, H, I, E, A, P>& l, const compact_hash_multiset<V, H, I, E, A, P>& r);
+};
+
+template <class V, class H, class I, class E, class A, class P>
+bool
+operator==(const compact_hash_multiset<V, H, I, E, A, P>& l, const compact_hash_multiset<V, H, I, E, A, P>& r)
+{
+  return l.size_ == r.size_ && l.underlying_ == r.underlying_;
+}
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_COMPACT_HASH_MULTISET_H
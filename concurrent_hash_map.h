@@ -0,0 +1,369 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef HASHCOL_CONCURRENT_HASH_MAP_H
+#define HASHCOL_CONCURRENT_HASH_MAP_H
+
+#include "config.h"
+
+#ifndef HASHCOL_HAS_CXX11
+  #error "concurrent_hash_map.h needs C++11 (std::atomic, std::thread)."
+#endif
+
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#ifdef HASHCOL_HAS_SSE2
+  #include <emmintrin.h>
+#endif
+
+#include "hash_map.h"
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+//A reader/writer spin lock in one word: the count of readers inside, plus a
+//bit for the writer. A writer sets its bit first, which keeps new readers 
+//out, and then waits for the ones inside to leave.
+
+class shared_spin_lock
+{
+public:
+  shared_spin_lock():state_(0){}
+  shared_spin_lock(const shared_spin_lock&) = delete;
+  shared_spin_lock& operator=(const shared_spin_lock&) = delete;
+
+  void lock()
+  {
+    unsigned spins = 0;
+    unsigned s = this->state_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      if (!(s & WRITER))
+      {
+        if (this->state_.compare_exchange_weak(s, s | WRITER, std::memory_order_acquire)) break;
+      }
+      else
+      {
+        relax(spins);
+        s = this->state_.load(std::memory_order_relaxed);
+      }
+    }
+    while (this->state_.load(std::memory_order_acquire) != WRITER) relax(spins);
+  }
+  void unlock(){this->state_.store(0, std::memory_order_release);}
+
+  void lock_shared()
+  {
+    unsigned spins = 0;
+    unsigned s = this->state_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      if (!(s & WRITER))
+      {
+        if (this->state_.compare_exchange_weak(s, s + 1, std::memory_order_acquire)) return;
+      }
+      else
+      {
+        relax(spins);
+        s = this->state_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+  void unlock_shared(){this->state_.fetch_sub(1, std::memory_order_release);}
+
+private:
+  enum {WRITER = 1u << 31, SPINS_BEFORE_YIELD = 64};
+
+  //Busy waits a little, then gives the core away: the holder may be waiting
+  //for it.
+  static void relax(unsigned& spins)
+  {
+    if (++spins < SPINS_BEFORE_YIELD)
+    {
+#ifdef HASHCOL_HAS_SSE2
+      _mm_pause();
+#endif
+    }
+    else
+    {
+      spins = 0;
+      std::this_thread::yield();
+    }
+  }
+
+  std::atomic<unsigned> state_;
+};
+
+
+/**********************************************************************************
+
+NOTES:
+
+  - A hash_map split into shards, each one locked on its own, so threads 
+  working on different keys seldom wait for each other. Keys are sent to 
+  shards by the high bits of their (remixed) hash; the shard's table uses
+  the hash as usual, so the two choices do not interfere.
+
+  - Elements are never handed out: lookups and updates take a function that
+  is called on the element while its shard is locked (shared for find(), 
+  exclusive for the rest). It should be short and must not use the map.
+
+  - Every shard grows (and resizes incrementally, with incremental_growth) 
+  by itself, under its own lock. Whole-map operations (size, for_each, 
+  clear) go through the shards one at a time, so they see no single point
+  in time while other threads write.
+
+  - Shards are padded to whole cache lines, so that locking one does not 
+  slow down threads working on its neighbours.
+
+***********************************************************************************/
+
+template <
+  class key_t, 
+  class value_t, 
+  class hash_fcn_t = hash<key_t>, 
+  class increment_t = unit_increment<key_t>,
+  class equal_key_t = std::equal_to<key_t>, 
+  class alloc_t = std::allocator<std::pair<key_t, value_t> >,
+  class growth_t = modulo_growth>
+class concurrent_hash_map 
+{
+private:
+  typedef concurrent_hash_map<key_t, value_t, hash_fcn_t, increment_t, equal_key_t, alloc_t, growth_t> Self;
+  typedef hash_map<key_t, value_t, hash_fcn_t, increment_t, equal_key_t, alloc_t, growth_t> Map;
+
+public:
+  typedef typename Map::key_type key_type;
+  typedef typename Map::data_type data_type;
+  typedef typename Map::value_type value_type;
+  typedef typename Map::size_type size_type;
+  typedef typename Map::hasher hasher;
+  typedef typename Map::key_equal key_equal;
+
+  enum {DEFAULT_SHARDS = 64};
+
+  explicit concurrent_hash_map(size_type max = 100, size_type shards = DEFAULT_SHARDS):
+    hash_(),SHARDS_(next_power_of_two(shards)),
+    shards_(make_shards(SHARDS_, max, hasher(), key_equal())){}
+  concurrent_hash_map(size_type max, size_type shards, const hasher& h, const key_equal& eq = key_equal()):
+    hash_(h),SHARDS_(next_power_of_two(shards)),
+    shards_(make_shards(SHARDS_, max, h, eq)){}
+
+  concurrent_hash_map(const Self&) = delete;
+  Self& operator=(const Self&) = delete;
+
+  hasher hash_funct()const{return this->hash_;}
+  size_type shard_count()const{return this->SHARDS_;}
+
+  //Calls f(const value_type&) on the element with key k, if there is one.
+  template <class function_t>
+  bool find(const key_type& k, function_t f)const
+  {
+    const Shard& s = this->shard(k);
+    SharedGuard g(s.lock_);
+    typename Map::const_iterator it = s.map_.find(k);
+    if (it == s.map_.end()) return false;
+    f(*it);
+    return true;
+  }
+  size_type count(const key_type& k)const
+  {
+    const Shard& s = this->shard(k);
+    SharedGuard g(s.lock_);
+    return s.map_.count(k);
+  }
+
+  //Returns whether x was inserted, i.e. its key was not there.
+  bool insert(const value_type& x)
+  {
+    Shard& s = this->shard(x.first);
+    std::lock_guard<shared_spin_lock> g(s.lock_);
+    return s.map_.insert(x).second;
+  }
+  bool insert(value_type&& x)
+  {
+    Shard& s = this->shard(x.first);
+    std::lock_guard<shared_spin_lock> g(s.lock_);
+    return s.map_.insert(std::move(x)).second;
+  }
+
+  //Inserts (k, d), or else assigns d to the element with key k. Returns 
+  //whether it inserted.
+  template <class data_t>
+  bool upsert(const key_type& k, data_t&& d)
+  {
+    Shard& s = this->shard(k);
+    std::lock_guard<shared_spin_lock> g(s.lock_);
+    return s.map_.insert_or_assign(k, std::forward<data_t>(d)).second;
+  }
+  //Inserts (k, d), or else calls f(data_type&) on the element with key k,
+  //e.g. to add to a count. A single lookup either way.
+  template <class data_t, class function_t>
+  bool upsert(const key_type& k, data_t&& d, function_t f)
+  {
+    Shard& s = this->shard(k);
+    std::lock_guard<shared_spin_lock> g(s.lock_);
+    std::pair<typename Map::iterator, bool> r = s.map_.try_emplace(k, std::forward<data_t>(d));
+    if (!r.second) f(r.first->second);
+    return r.second;
+  }
+
+  size_type erase(const key_type& k)
+  {
+    Shard& s = this->shard(k);
+    std::lock_guard<shared_spin_lock> g(s.lock_);
+    return s.map_.erase(k);
+  }
+
+  //Calls f on every element of shard i, which is locked meanwhile (shared 
+  //for the const version). Shards can be walked by different threads.
+  template <class function_t>
+  void for_each_in_shard(size_type i, function_t f)
+  {
+    Shard& s = this->shards_[i];
+    std::lock_guard<shared_spin_lock> g(s.lock_);
+    for (typename Map::iterator it = s.map_.begin(); it != s.map_.end(); ++it) f(*it);
+  }
+  template <class function_t>
+  void for_each_in_shard(size_type i, function_t f)const
+  {
+    const Shard& s = this->shards_[i];
+    SharedGuard g(s.lock_);
+    for (typename Map::const_iterator it = s.map_.begin(); it != s.map_.end(); ++it) f(*it);
+  }
+  template <class function_t>
+  void for_each(function_t f)
+  {
+    for (size_type i = 0; i != this->SHARDS_; ++i) this->for_each_in_shard(i, f);
+  }
+  template <class function_t>
+  void for_each(function_t f)const
+  {
+    for (size_type i = 0; i != this->SHARDS_; ++i) this->for_each_in_shard(i, f);
+  }
+
+  size_type size()const
+  {
+    size_type n = 0;
+    for (size_type i = 0; i != this->SHARDS_; ++i)
+    {
+      SharedGuard g(this->shards_[i].lock_);
+      n += this->shards_[i].map_.size();
+    }
+    return n;
+  }
+  bool empty()const{return 0 == this->size();}
+  void clear()
+  {
+    for (size_type i = 0; i != this->SHARDS_; ++i)
+    {
+      std::lock_guard<shared_spin_lock> g(this->shards_[i].lock_);
+      this->shards_[i].map_.clear();
+    }
+  }
+  //Room for about n elements in all, if the hash spreads them evenly.
+  void reserve(size_type n)
+  {
+    for (size_type i = 0; i != this->SHARDS_; ++i)
+    {
+      std::lock_guard<shared_spin_lock> g(this->shards_[i].lock_);
+      this->shards_[i].map_.reserve(n / this->SHARDS_ + 1);
+    }
+  }
+
+private:
+  enum {CACHE_LINE = 64};
+
+  //The padding goes first, so the lock is a whole line away from the 
+  //previous shard, which other threads write to.
+  struct Shard
+  {
+    Shard(size_type max, const hasher& h, const key_equal& eq):map_(max, h, eq){}
+
+    char padding_[CACHE_LINE];
+    mutable shared_spin_lock lock_;
+    Map map_;
+  };
+
+  //Shards are built in place, each with its map sized from the start. The 
+  //deleter destroys the n_ built so far, so none leaks if one throws.
+  struct ShardDeleter
+  {
+    size_type n_;
+    void operator()(Shard* p)const
+    {
+      for (size_type i = this->n_; i != 0; --i) p[i - 1].~Shard();
+      ::operator delete(p);
+    }
+  };
+  typedef std::unique_ptr<Shard[], ShardDeleter> Shards;
+
+  static Shards make_shards(size_type n, size_type max, const hasher& h, const key_equal& eq)
+  {
+    static_assert(alignof(Shard) <= alignof(std::max_align_t), "shards need no extended alignment");
+    Shards shards(static_cast<Shard*>(::operator new(n * sizeof(Shard))), ShardDeleter{0});
+    for (size_type& i = shards.get_deleter().n_; i != n; ++i) new (&shards[i]) Shard(max / n + 1, h, eq);
+    return shards;
+  }
+
+  struct SharedGuard
+  {
+    explicit SharedGuard(shared_spin_lock& l):lock_(l){l.lock_shared();}
+    ~SharedGuard(){this->lock_.unlock_shared();}
+    shared_spin_lock& lock_;
+  };
+
+  Shard& shard(const key_type& k)
+  {
+    return this->shards_[this->shard_index(k)];
+  }
+  const Shard& shard(const key_type& k)const
+  {
+    return this->shards_[this->shard_index(k)];
+  }
+  size_type shard_index(const key_type& k)const
+  {
+    hash_word h = mix_word<fmix64_mixer>(static_cast<hash_word>(this->hash_(k)));
+    return static_cast<size_type>(h >> 32) & (this->SHARDS_ - 1);
+  }
+
+  hasher hash_;
+  size_type SHARDS_;
+  Shards shards_;
+};
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_CONCURRENT_HASH_MAP_H
@@ -32,5 +32,31 @@
 #define HASHCOL_BEGIN_NAMESPACE namespace hashcol {
 #define HASHCOL_END_NAMESPACE }
 
+//SIMD support for group probing. Define HASHCOL_NO_SIMD to force the portable
+//code path.
+#if !defined(HASHCOL_NO_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+  #define HASHCOL_HAS_SSE2
+#endif
+
+//AVX2 and AVX-512 (F and DQ) for hashing integer keys in batches. Only used
+//when the compiler targets them (e.g. -mavx2, -march=native).
+#if !defined(HASHCOL_NO_SIMD) && defined(__AVX2__)
+  #define HASHCOL_HAS_AVX2
+#endif
+#if !defined(HASHCOL_NO_SIMD) && defined(__AVX512F__) && defined(__AVX512DQ__)
+  #define HASHCOL_HAS_AVX512
+#endif
+
+//Move semantics, used when elements change place.
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+  #define HASHCOL_HAS_CXX11
+#endif
+
+//std::string_view, hashed like std::string.
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+  #define HASHCOL_HAS_STRING_VIEW
+#endif
+
 
 #endif //HASHCOL_CONFIG_H
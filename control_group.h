@@ -0,0 +1,152 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef HASHCOL_CONTROL_GROUP_H
+#define HASHCOL_CONTROL_GROUP_H
+
+#include <cstddef>
+#include <climits>
+
+#include "config.h"
+#include "bit_ops.h"
+#include "hash_function.h"
+
+#ifdef HASHCOL_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+//Control bytes of group probed tables. A full slot holds the 7-bit hash
+//fragment (H2) of its element. Empty and deleted slots have the sign bit set.
+
+typedef signed char ctrl_t;
+
+enum {CTRL_EMPTY = -128, CTRL_DELETED = -2};
+
+
+//Sixteen control bytes loaded at once. Every match returns a bit mask with
+//bit i set for slot i of the group.
+
+#ifdef HASHCOL_HAS_SSE2
+
+struct control_group
+{
+  enum {WIDTH = 16};
+
+  __m128i ctrl_;
+
+  explicit control_group(const ctrl_t* p):
+    ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))){}
+
+  unsigned match(ctrl_t h2)const
+  {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), this->ctrl_));
+  }
+  unsigned match_empty()const
+  {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(CTRL_EMPTY), this->ctrl_));
+  }
+  unsigned match_empty_or_deleted()const
+  {
+    return _mm_movemask_epi8(this->ctrl_);
+  }
+};
+
+#else
+
+struct control_group
+{
+  enum {WIDTH = 16};
+
+  const ctrl_t* ctrl_;
+
+  explicit control_group(const ctrl_t* p):ctrl_(p){}
+
+  unsigned match(ctrl_t h2)const
+  {
+    unsigned mask = 0;
+    for (int i = 0; i < WIDTH; ++i)
+      if (this->ctrl_[i] == h2) mask |= 1u << i;
+    return mask;
+  }
+  unsigned match_empty()const{return this->match(CTRL_EMPTY);}
+  unsigned match_empty_or_deleted()const
+  {
+    unsigned mask = 0;
+    for (int i = 0; i < WIDTH; ++i)
+      if (this->ctrl_[i] < 0) mask |= 1u << i;
+    return mask;
+  }
+};
+
+#endif
+
+
+//Splits a hash into the starting group (H1, taken from the high bits of the
+//mixed hash) and the control byte fragment (H2, the 7 bits right below).
+
+inline void split_group_hash(std::size_t h,
+                             std::size_t num_groups_log2,
+                             std::size_t& h1,
+                             ctrl_t& h2)
+{
+  std::size_t top = fibonacci_mix(h) >>
+    (sizeof(std::size_t) * CHAR_BIT - 7 - num_groups_log2);
+  h1 = top >> 7;
+  h2 = static_cast<ctrl_t>(top & 0x7F);
+}
+
+
+//Triangular walk over a power of two number of groups. It visits every group
+//exactly once before repeating.
+
+class group_probe_sequence
+{
+public:
+  group_probe_sequence(std::size_t group, std::size_t num_groups):
+    group_(group),mask_(num_groups - 1),index_(0){}
+
+  std::size_t offset()const{return this->group_ * control_group::WIDTH;}
+  void next()
+  {
+    ++this->index_;
+    this->group_ = (this->group_ + this->index_) & this->mask_;
+  }
+
+private:
+  std::size_t group_;
+  std::size_t mask_;
+  std::size_t index_;
+};
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_CONTROL_GROUP_H
@@ -0,0 +1,174 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef HASHCOL_EPOCH_H
+#define HASHCOL_EPOCH_H
+
+#include "config.h"
+
+#ifndef HASHCOL_HAS_CXX11
+  #error "epoch.h needs C++11 (std::atomic, thread_local)."
+#endif
+
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+/**********************************************************************************
+
+NOTES:
+
+  - Epoch based reclamation: tells writers when memory that readers may 
+  still be looking at can be freed, without readers taking locks.
+
+  - There is a global epoch. A reader announces the epoch it starts in, in a
+  record of its own thread, and clears it when done. Only plain atomic loads,
+  stores and one fence; no read-modify-write.
+
+  - A writer that unlinks something retires it with advance(), which moves 
+  the epoch on and returns the old one. Once every reader that is inside has
+  announced a later epoch than that, no reader can still hold it.
+
+  - Threads get their record the first time they read, and hand it back when
+  they exit. Records are never freed, so writers can walk them any time.
+
+***********************************************************************************/
+
+class epoch_domain
+{
+public:
+  //The one domain all containers share.
+  static epoch_domain& instance()
+  {
+    static epoch_domain domain;
+    return domain;
+  }
+
+  //Readers. Nested sections count as the outermost one.
+  void enter()
+  {
+    Record* r = this->record();
+    if (r->depth_++ == 0)
+    {
+      r->epoch_.store(this->epoch_.load(), std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+  void leave()
+  {
+    Record* r = this->record();
+    if (--r->depth_ == 0) r->epoch_.store(QUIESCENT, std::memory_order_release);
+  }
+
+  //Writers. advance() must come after what it retires has been unlinked.
+  std::size_t advance(){return this->epoch_.fetch_add(1);}
+  //What was retired before this epoch can no longer be seen by a reader.
+  std::size_t oldest_reader()const
+  {
+    std::size_t oldest = this->epoch_.load();
+    for (Record* r = this->records_.load(std::memory_order_acquire); r != 0; r = r->next_)
+    {
+      std::size_t e = r->epoch_.load();
+      if (e != QUIESCENT && e < oldest) oldest = e;
+    }
+    return oldest;
+  }
+
+  //Reads within a scope.
+  class guard
+  {
+  public:
+    guard():domain_(epoch_domain::instance()){this->domain_.enter();}
+    ~guard(){this->domain_.leave();}
+    guard(const guard&) = delete;
+    guard& operator=(const guard&) = delete;
+  private:
+    epoch_domain& domain_;
+  };
+
+private:
+  enum {QUIESCENT = 0, CACHE_LINE = 64};
+
+  struct Record
+  {
+    Record():epoch_(QUIESCENT),in_use_(true),depth_(0),next_(0){}
+    std::atomic<std::size_t> epoch_;
+    std::atomic<bool> in_use_;
+    unsigned depth_;
+    Record* next_;
+    char padding_[CACHE_LINE]; //Readers write their records all the time.
+  };
+
+  //Gives the record back when its thread exits.
+  struct Owner
+  {
+    Owner():record_(0){}
+    ~Owner(){if (this->record_ != 0) this->record_->in_use_.store(false, std::memory_order_release);}
+    Record* record_;
+  };
+
+  epoch_domain():epoch_(QUIESCENT + 1),records_(0){}
+  epoch_domain(const epoch_domain&) = delete;
+  epoch_domain& operator=(const epoch_domain&) = delete;
+
+  Record* record()
+  {
+    static thread_local Owner owner;
+    if (owner.record_ == 0) owner.record_ = this->acquire();
+    return owner.record_;
+  }
+  Record* acquire()
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    for (Record* r = this->records_.load(std::memory_order_relaxed); r != 0; r = r->next_)
+    {
+      if (!r->in_use_.load(std::memory_order_acquire))
+      {
+        r->in_use_.store(true, std::memory_order_relaxed);
+        return r;
+      }
+    }
+    Record* r = new Record;
+    r->next_ = this->records_.load(std::memory_order_relaxed);
+    this->records_.store(r, std::memory_order_release);
+    return r;
+  }
+
+  std::atomic<std::size_t> epoch_;
+  std::atomic<Record*> records_;
+  std::mutex mutex_;
+};
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_EPOCH_H
@@ -0,0 +1,125 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef HASHCOL_FROZEN_HASH_MAP_H
+#define HASHCOL_FROZEN_HASH_MAP_H
+
+
+#include "frozen_hash_table.h"
+#include "identity.h"
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+//An immutable hash_map over a minimal perfect hash (frozen_hash_table.h), 
+//usually made by hash_map::freeze().
+template <
+  class key_t, 
+  class value_t, 
+  class hash_fcn_t = hash<key_t>, 
+  class equal_key_t = std::equal_to<key_t>, 
+  class alloc_t = std::allocator<std::pair<key_t, value_t> > >
+class frozen_hash_map 
+{
+private:
+  typedef frozen_hash_map<key_t, value_t, hash_fcn_t, equal_key_t, alloc_t> Self;
+
+  typedef std::pair<key_t, value_t> Map_pair;
+  typedef frozen_hash_table__<
+    key_t,
+    Map_pair,
+    hash_fcn_t,
+    equal_key_t,
+    select1st<Map_pair>,
+    alloc_t> HT; 
+
+  HT underlying_;
+
+public:
+  typedef typename HT::key_type key_type;
+  typedef value_t data_type;
+  typedef typename HT::value_type value_type;
+  typedef typename HT::size_type size_type;
+  typedef typename HT::hasher hasher;
+  typedef typename HT::key_equal key_equal;
+  typedef typename HT::pointer pointer;
+  typedef typename HT::reference reference;
+  typedef typename HT::const_reference const_reference;
+  typedef typename HT::allocator allocator;
+  typedef typename HT::iterator iterator;
+  typedef typename HT::const_iterator const_iterator;
+  typedef typename HT::difference_type difference_type;
+
+  explicit frozen_hash_map(const hasher& h = hasher(), const key_equal& eq = key_equal()):
+    underlying_(h, eq){}
+
+  template <class input_iterator_t>
+  frozen_hash_map(input_iterator_t b, input_iterator_t e, const hasher& h = hasher(), 
+                  const key_equal& eq = key_equal()):
+    underlying_(h, eq)
+  {
+    this->underlying_.build(b, e);
+  }
+
+  //Getters.
+  hasher hash_funct()const{return this->underlying_.hash_funct();}
+  key_equal key_eq()const{return this->underlying_.key_eq();}
+
+  void swap(Self& other){this->underlying_.swap(other.underlying_);}
+
+  //Replaces the elements with those of [b, e), in tasks that run may spread
+  //over threads (parallel_build.h).
+  template <class input_iterator_t, class runner_t>
+  void build(input_iterator_t b, input_iterator_t e, runner_t& run)
+  {
+    this->underlying_.build(b, e, run);
+  }
+
+  const_iterator find(const key_type& k)const{return this->underlying_.find(k);}
+  size_type count(const key_type& k)const{return this->underlying_.count(k);}
+
+  //Heterogeneous lookups, if both hasher and key_equal are transparent.
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, const_iterator>::type 
+  find(const K& k)const{return this->underlying_.find(k);}
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, size_type>::type 
+  count(const K& k)const{return this->underlying_.count(k);}
+
+  size_type size()const{return this->underlying_.size();}
+  bool empty()const{return this->underlying_.empty();}
+  size_type memory()const{return this->underlying_.memory();}
+
+  const_iterator begin()const{return this->underlying_.begin();}
+  const_iterator end()const{return this->underlying_.end();}
+};
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_FROZEN_HASH_MAP_H
@@ -0,0 +1,553 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef HASHCOL_FROZEN_HASH_TABLE_H
+#define HASHCOL_FROZEN_HASH_TABLE_H
+
+#include <cstddef>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "config.h"
+#include "hash_function.h"
+#include "transparency.h"
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+/**********************************************************************************
+
+NOTES:
+
+  - An immutable table over a minimal perfect hash, after PTHash (Pibiri and
+  Trani): the keys are split into partitions of a few thousand, the keys of
+  a partition into buckets, and each bucket gets a pilot, a small number 
+  found by trial so that the slots its keys hash to (together with it) are 
+  free. A lookup reads the pilot of the key's bucket and then exactly one
+  element, which holds the key if the table has it. There are no probes and 
+  no empty slots: the elements are stored n in a row, and about one byte per
+  key goes to pilots.
+
+  - Slots are taken from a table about 3% larger than the partition, which
+  makes pilots much quicker to find; the keys that land past the end are 
+  sent to the free slots through a small table.
+
+  - Partitions are built independently, in tasks handed to a runner like 
+  build() in hash_table.h (parallel_build.h). Equal keys are kept once, the
+  first of them. Different keys with the same hash (only possible if the
+  hasher collides) are kept at the end, in a list searched after a miss.
+
+  - hash_fcn_t must be deterministic, and its values are remixed, so weak 
+  hashes work as well as strong ones.
+
+***********************************************************************************/
+
+template <
+  class key_t,
+  class value_t,
+  class hash_fcn_t,
+  class equal_key_t,
+  class get_key_t,
+  class alloc_t>
+class frozen_hash_table__
+{
+private:
+  typedef frozen_hash_table__<key_t, value_t, hash_fcn_t, equal_key_t, get_key_t, alloc_t> Self;
+  typedef std::vector<value_t, alloc_t> Values;
+
+public:
+  typedef key_t key_type;
+  typedef value_t value_type;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef hash_fcn_t hasher;
+  typedef equal_key_t key_equal;
+  typedef const value_t* pointer;
+  typedef const value_t& reference;
+  typedef const value_t& const_reference;
+  typedef alloc_t allocator;
+  typedef typename Values::const_iterator iterator;
+  typedef typename Values::const_iterator const_iterator;
+
+private:
+  enum {PARTITION_SIZE = 4096, BUCKET_SIZE = 4, BUILD_CHUNKS = 256};
+  //About 60% of the keys go to the first 30% of the buckets (out of 2^16 and 
+  //10), so the big buckets are placed while the table is still empty.
+  enum {DENSE_KEYS = 39322, DENSE_BUCKETS = 3};
+
+  //Partition i holds values_[offset_, offset_ + size_), its pilots start at 
+  //pilots_[pilots_] and its remapped slots at remap_[remap_].
+  struct Partition
+  {
+    size_type offset_;
+    size_type size_;
+    size_type table_size_;
+    size_type buckets_;
+    size_type dense_buckets_;
+    size_type pilots_;
+    size_type remap_;
+    Partition():offset_(0),size_(0),table_size_(0),buckets_(0),dense_buckets_(0),pilots_(0),remap_(0){}
+  };
+
+  //An input range given as pointers to its elements.
+  struct Indirect
+  {
+    const value_type* const* first_;
+    explicit Indirect(const value_type* const* first):first_(first){}
+  };
+
+  struct SerialRunner
+  {
+    template <class task_t>
+    void operator()(size_type n, task_t& task)const
+    {
+      for (size_type i = 0; i != n; ++i) task(i);
+    }
+  };
+
+  std::vector<Partition> partitions_;
+  std::vector<unsigned int> pilots_;
+  std::vector<unsigned int> remap_;
+  std::vector<std::pair<hash_word, size_type> > overflow_; //Hash and position, sorted.
+  Values values_;
+  hasher hash_;
+  key_equal equal_;
+  get_key_t get_key_;
+
+  //The high word of h * n, which is below n.
+  static hash_word scale(hash_word h, hash_word n)
+  {
+    wide_multiply(h, n);
+    return n;
+  }
+  template <class K>
+  hash_word hash_key(const K& k)const
+  {
+    return mix_word<fmix64_mixer>(static_cast<hash_word>(this->hash_(k)));
+  }
+  //Partitions take the high bits of the hash, buckets the middle ones (the
+  //low bits decide between dense and sparse buckets) and slots all of them,
+  //mixed with the pilot.
+  const Partition& partition_of(hash_word h)const
+  {
+    return this->partitions_[size_type(scale(h, this->partitions_.size()))];
+  }
+  static size_type bucket_of(const Partition& p, hash_word h)
+  {
+    hash_word middle = (h >> 16) & 0xFFFFFFFFu;
+    if ((h & 0xFFFFu) < DENSE_KEYS) return size_type((middle * p.dense_buckets_) >> 32);
+    return p.dense_buckets_ + size_type((middle * (p.buckets_ - p.dense_buckets_)) >> 32);
+  }
+  static size_type slot_of(const Partition& p, hash_word h, unsigned int pilot)
+  {
+    hash_word x = h ^ (pilot * make_word(0x9E3779B9u, 0x7F4A7C15u));
+    return size_type(scale(mix_word<splitmix64_mixer>(x), p.table_size_));
+  }
+
+  template <class K>
+  const value_type* lookup(const K& k)const
+  {
+    hash_word h = this->hash_key(k);
+    const Partition& p = this->partition_of(h);
+    if (p.size_ == 0) return 0;
+    size_type s = slot_of(p, h, this->pilots_[p.pilots_ + bucket_of(p, h)]);
+    if (s >= p.size_) s = this->remap_[p.remap_ + s - p.size_];
+    const value_type& x = this->values_[p.offset_ + s];
+    if (this->equal_(this->get_key_(x), k)) return &x;
+    return this->overflow_.empty() ? 0 : this->lookup_overflow(k, h);
+  }
+  template <class K>
+  const value_type* lookup_overflow(const K& k, hash_word h)const
+  {
+    typename std::vector<std::pair<hash_word, size_type> >::const_iterator it = 
+      std::lower_bound(this->overflow_.begin(), this->overflow_.end(), std::make_pair(h, size_type(0)));
+    for (; it != this->overflow_.end() && it->first == h; ++it)
+      if (this->equal_(this->get_key_(this->values_[it->second]), k)) return &this->values_[it->second];
+    return 0;
+  }
+  template <class K>
+  const_iterator find_key(const K& k)const
+  {
+    const value_type* x = this->lookup(k);
+    return x == 0 ? this->values_.end() : this->values_.begin() + (x - &this->values_[0]);
+  }
+
+  //Where build() gets its elements from: a random access range or pointers.
+  template <class random_iterator_t>
+  static const value_type& source_at(random_iterator_t b, size_type j){return b[j];}
+  static const value_type& source_at(Indirect b, size_type j){return *b.first_[j];}
+
+  //What the search in a partition found: the slots of its keys (input 
+  //position, slot), pilots, remapped slots, and keys left to the overflow 
+  //list (hash, input position).
+  struct Found
+  {
+    std::vector<std::pair<size_type, size_type> > placed_;
+    std::vector<unsigned int> pilots_;
+    std::vector<unsigned int> remap_;
+    std::vector<std::pair<hash_word, size_type> > overflow_;
+
+    void release()
+    {
+      std::vector<std::pair<size_type, size_type> >().swap(this->placed_);
+      std::vector<unsigned int>().swap(this->pilots_);
+      std::vector<unsigned int>().swap(this->remap_);
+    }
+  };
+
+  //The steps of build(), run as tasks: hashing, counting and scattering work
+  //on chunks of the input, searching and placing on partitions.
+  template <class source_t>
+  struct BuildState
+  {
+    Self* table_;
+    source_t first_;
+    size_type size_;
+    size_type chunk_;
+    size_type partitions_;
+    std::vector<hash_word> hashes_;
+    std::vector<size_type> counts_; //Chunk by partition, then where each goes.
+    std::vector<size_type> order_; //Input positions, by partition.
+    std::vector<size_type> partition_begin_;
+    std::vector<Found> found_;
+
+    BuildState(Self* table, source_t first, size_type n):
+      table_(table),
+      first_(first),
+      size_(n),
+      chunk_((n + BUILD_CHUNKS - 1) / BUILD_CHUNKS),
+      partitions_(std::max<size_type>(1, n / PARTITION_SIZE)){}
+
+    size_type chunk_begin(size_type i)const{return std::min(i * this->chunk_, this->size_);}
+    size_type partition_of(size_type j)const{return size_type(scale(this->hashes_[j], this->partitions_));}
+  };
+  template <class source_t>
+  struct HashTask
+  {
+    BuildState<source_t>& s_;
+    explicit HashTask(BuildState<source_t>& s):s_(s){}
+    void operator()(size_type i)
+    {
+      for (size_type j = this->s_.chunk_begin(i); j != this->s_.chunk_begin(i + 1); ++j)
+        this->s_.hashes_[j] = this->s_.table_->hash_key(this->s_.table_->get_key_(source_at(this->s_.first_, j)));
+    }
+  };
+  template <class source_t>
+  struct CountTask
+  {
+    BuildState<source_t>& s_;
+    explicit CountTask(BuildState<source_t>& s):s_(s){}
+    void operator()(size_type i)
+    {
+      size_type* counts = &this->s_.counts_[i * this->s_.partitions_];
+      for (size_type j = this->s_.chunk_begin(i); j != this->s_.chunk_begin(i + 1); ++j)
+        ++counts[this->s_.partition_of(j)];
+    }
+  };
+  template <class source_t>
+  struct ScatterTask
+  {
+    BuildState<source_t>& s_;
+    explicit ScatterTask(BuildState<source_t>& s):s_(s){}
+    void operator()(size_type i)
+    {
+      size_type* next = &this->s_.counts_[i * this->s_.partitions_];
+      for (size_type j = this->s_.chunk_begin(i); j != this->s_.chunk_begin(i + 1); ++j)
+        this->s_.order_[next[this->s_.partition_of(j)]++] = j;
+    }
+  };
+  template <class source_t>
+  struct SearchTask
+  {
+    BuildState<source_t>& s_;
+    explicit SearchTask(BuildState<source_t>& s):s_(s){}
+    void operator()(size_type i)
+    {
+      this->s_.table_->search(this->s_, i);
+    }
+  };
+  template <class source_t>
+  struct PlaceTask
+  {
+    BuildState<source_t>& s_;
+    explicit PlaceTask(BuildState<source_t>& s):s_(s){}
+    void operator()(size_type i)
+    {
+      Self& t = *this->s_.table_;
+      Found& f = this->s_.found_[i];
+      const Partition& p = t.partitions_[i];
+      for (size_type j = 0; j != f.placed_.size(); ++j)
+        t.values_[p.offset_ + f.placed_[j].second] = source_at(this->s_.first_, f.placed_[j].first);
+      std::copy(f.pilots_.begin(), f.pilots_.end(), t.pilots_.begin() + p.pilots_);
+      std::copy(f.remap_.begin(), f.remap_.end(), t.remap_.begin() + p.remap_);
+      f.release();
+    }
+  };
+
+  //Finds the pilots of partition i. Its keys are sorted by hash, to drop 
+  //repeated keys, then by bucket, and the buckets are placed biggest first.
+  template <class source_t>
+  void search(BuildState<source_t>& s, size_type i)const
+  {
+    Found& f = s.found_[i];
+    std::vector<std::pair<hash_word, size_type> > keys;
+    keys.reserve(s.partition_begin_[i + 1] - s.partition_begin_[i]);
+    for (size_type j = s.partition_begin_[i]; j != s.partition_begin_[i + 1]; ++j)
+      keys.push_back(std::make_pair(s.hashes_[s.order_[j]], s.order_[j]));
+    std::sort(keys.begin(), keys.end());
+    size_type n = 0;
+    for (size_type j = 0, run = 0; j != keys.size(); ++j)
+    {
+      if (j != 0 && keys[j].first == keys[j - 1].first)
+      {
+        if (!this->repeated(s.first_, keys, run, n, f.overflow_, keys[j])) f.overflow_.push_back(keys[j]);
+        continue;
+      }
+      run = n;
+      keys[n++] = keys[j];
+    }
+    keys.resize(n);
+
+    Partition p;
+    p.size_ = n;
+    p.table_size_ = n + (n + 31) / 32;
+    p.buckets_ = (n + BUCKET_SIZE - 1) / BUCKET_SIZE;
+    p.dense_buckets_ = p.buckets_ * DENSE_BUCKETS / 10;
+    std::vector<std::pair<size_type, size_type> > buckets; //Bucket and key.
+    buckets.reserve(n);
+    for (size_type j = 0; j != n; ++j) buckets.push_back(std::make_pair(bucket_of(p, keys[j].first), j));
+    std::sort(buckets.begin(), buckets.end());
+    std::vector<std::pair<size_type, size_type> > by_size; //n - size and first key.
+    for (size_type j = 0, e; j != n; j = e)
+    {
+      for (e = j + 1; e != n && buckets[e].first == buckets[j].first; ++e);
+      by_size.push_back(std::make_pair(n - (e - j), j));
+    }
+    std::sort(by_size.begin(), by_size.end());
+
+    f.pilots_.assign(p.buckets_, 0);
+    f.placed_.resize(n);
+    std::vector<bool> taken(p.table_size_, false);
+    std::vector<size_type> slots;
+    for (size_type b = 0; b != by_size.size(); ++b)
+    {
+      size_type first = by_size[b].second, size = n - by_size[b].first;
+      slots.resize(size);
+      unsigned int pilot = 0;
+      for (size_type k = 0; k != size; ++pilot)
+      {
+        for (k = 0; k != size; ++k)
+        {
+          size_type slot = slot_of(p, keys[buckets[first + k].second].first, pilot);
+          if (taken[slot]) break;
+          taken[slot] = true;
+          slots[k] = slot;
+        }
+        if (k == size) break;
+        while (k != 0) taken[slots[--k]] = false;
+      }
+      f.pilots_[buckets[first].first] = pilot;
+      for (size_type k = 0; k != size; ++k)
+        f.placed_[first + k] = std::make_pair(keys[buckets[first + k].second].second, slots[k]);
+    }
+
+    //Slots past the end move to the free ones before it, in order.
+    f.remap_.assign(p.table_size_ - n, 0);
+    size_type free = 0;
+    for (size_type slot = n; slot != p.table_size_; ++slot)
+    {
+      if (!taken[slot]) continue;
+      while (taken[free]) ++free;
+      f.remap_[slot - n] = static_cast<unsigned int>(free++);
+    }
+    for (size_type j = 0; j != n; ++j)
+      if (f.placed_[j].second >= n) f.placed_[j].second = f.remap_[f.placed_[j].second - n];
+  }
+  //Whether the key at x (with the hash of keys[run, n)) is one of those or
+  //of the ones in overflow with that hash.
+  template <class source_t>
+  bool repeated(source_t first, const std::vector<std::pair<hash_word, size_type> >& keys, size_type run, 
+                size_type n, const std::vector<std::pair<hash_word, size_type> >& overflow,
+                const std::pair<hash_word, size_type>& x)const
+  {
+    const key_type& k = this->get_key_(source_at(first, x.second));
+    for (size_type j = run; j != n; ++j)
+      if (this->equal_(this->get_key_(source_at(first, keys[j].second)), k)) return true;
+    for (size_type j = overflow.size(); j != 0 && overflow[j - 1].first == x.first; --j)
+      if (this->equal_(this->get_key_(source_at(first, overflow[j - 1].second)), k)) return true;
+    return false;
+  }
+
+  template <class source_t, class runner_t>
+  void build_from(source_t b, size_type n, runner_t& run)
+  {
+    BuildState<source_t> s(this, b, n);
+    s.hashes_.resize(n);
+    s.counts_.resize(BUILD_CHUNKS * s.partitions_, 0);
+    s.order_.resize(n);
+    s.partition_begin_.resize(s.partitions_ + 1);
+    s.found_.resize(s.partitions_);
+
+    HashTask<source_t> hashing(s);
+    run(size_type(BUILD_CHUNKS), hashing);
+    CountTask<source_t> counting(s);
+    run(size_type(BUILD_CHUNKS), counting);
+    size_type total = 0;
+    for (size_type p = 0; p != s.partitions_; ++p)
+    {
+      s.partition_begin_[p] = total;
+      for (size_type i = 0; i != BUILD_CHUNKS; ++i)
+      {
+        size_type c = s.counts_[i * s.partitions_ + p];
+        s.counts_[i * s.partitions_ + p] = total;
+        total += c;
+      }
+    }
+    s.partition_begin_[s.partitions_] = total;
+    ScatterTask<source_t> scattering(s);
+    run(size_type(BUILD_CHUNKS), scattering);
+    SearchTask<source_t> searching(s);
+    run(s.partitions_, searching);
+    std::vector<hash_word>().swap(s.hashes_);
+
+    Self t(this->hash_, this->equal_);
+    t.partitions_.resize(s.partitions_);
+    size_type size = 0, pilots = 0, remap = 0;
+    std::vector<std::pair<hash_word, size_type> > overflow;
+    for (size_type p = 0; p != s.partitions_; ++p)
+    {
+      Partition& q = t.partitions_[p];
+      const Found& f = s.found_[p];
+      q.offset_ = size;
+      q.size_ = f.placed_.size();
+      q.table_size_ = q.size_ + f.remap_.size();
+      q.buckets_ = f.pilots_.size();
+      q.dense_buckets_ = q.buckets_ * DENSE_BUCKETS / 10;
+      q.pilots_ = pilots;
+      q.remap_ = remap;
+      size += q.size_;
+      pilots += f.pilots_.size();
+      remap += f.remap_.size();
+      overflow.insert(overflow.end(), f.overflow_.begin(), f.overflow_.end());
+    }
+    std::sort(overflow.begin(), overflow.end());
+    t.values_.resize(size + overflow.size());
+    t.pilots_.resize(pilots);
+    t.remap_.resize(remap);
+    s.table_ = &t;
+    PlaceTask<source_t> placing(s);
+    run(s.partitions_, placing);
+    for (size_type j = 0; j != overflow.size(); ++j)
+    {
+      t.values_[size + j] = source_at(b, overflow[j].second);
+      t.overflow_.push_back(std::make_pair(overflow[j].first, size + j));
+    }
+    this->swap(t);
+  }
+
+  template <class random_iterator_t, class runner_t>
+  void build_range(random_iterator_t b, random_iterator_t e, runner_t& run, std::random_access_iterator_tag)
+  {
+    this->build_from(b, e - b, run);
+  }
+  template <class input_iterator_t, class runner_t>
+  void build_range(input_iterator_t b, input_iterator_t e, runner_t& run, std::input_iterator_tag)
+  {
+    std::vector<const value_type*> elements;
+    for (; b != e; ++b) elements.push_back(&*b);
+    this->build_from(Indirect(elements.empty() ? 0 : &elements[0]), elements.size(), run);
+  }
+
+public:
+  explicit frozen_hash_table__(const hasher& h = hasher(), const key_equal& eq = key_equal()):
+    partitions_(1),
+    hash_(h),
+    equal_(eq),
+    get_key_(){}
+
+  //Getters.
+  hasher hash_funct()const{return this->hash_;}
+  key_equal key_eq()const{return this->equal_;}
+
+  void swap(Self& other)
+  {
+    this->partitions_.swap(other.partitions_);
+    this->pilots_.swap(other.pilots_);
+    this->remap_.swap(other.remap_);
+    this->overflow_.swap(other.overflow_);
+    this->values_.swap(other.values_);
+    std::swap(this->hash_, other.hash_);
+    std::swap(this->equal_, other.equal_);
+  }
+
+  //Replaces the elements with those of [b, e), keeping the first of equal 
+  //keys. The partitions are built in tasks: run(n, task) must call task(i) 
+  //for every i in [0, n) and return when all are done (parallel_build.h).
+  //The elements of [b, e) must stay put until it returns.
+  template <class input_iterator_t, class runner_t>
+  void build(input_iterator_t b, input_iterator_t e, runner_t& run)
+  {
+    this->build_range(b, e, run, typename std::iterator_traits<input_iterator_t>::iterator_category());
+  }
+  template <class input_iterator_t>
+  void build(input_iterator_t b, input_iterator_t e)
+  {
+    SerialRunner run;
+    this->build(b, e, run);
+  }
+
+  const_iterator find(const key_type& k)const{return this->find_key(k);}
+  size_type count(const key_type& k)const{return this->lookup(k) != 0;}
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, const_iterator>::type 
+  find(const K& k)const{return this->find_key(k);}
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, size_type>::type 
+  count(const K& k)const{return this->lookup(k) != 0;}
+
+  size_type size()const{return this->values_.size();}
+  bool empty()const{return this->values_.empty();}
+  //The bytes taken by the elements and by the hash function.
+  size_type memory()const
+  {
+    return this->values_.capacity() * sizeof(value_type) + this->pilots_.capacity() * sizeof(unsigned int) +
+           this->remap_.capacity() * sizeof(unsigned int) + this->partitions_.capacity() * sizeof(Partition) +
+           this->overflow_.capacity() * sizeof(std::pair<hash_word, size_type>);
+  }
+
+  const_iterator begin()const{return this->values_.begin();}
+  const_iterator end()const{return this->values_.end();}
+};
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_FROZEN_HASH_TABLE_H
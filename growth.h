@@ -0,0 +1,112 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef HASHCOL_GROWTH_H
+#define HASHCOL_GROWTH_H
+
+#include <cstddef>
+#include <climits>
+
+#include "config.h"
+#include "bit_ops.h"
+#include "hash_function.h"
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+//Growth policies decide the capacity of a hash table, when and how much it 
+//grows and how hash values are mapped into it. A policy provides (statically):
+//  - max_load_factor(): the initial load limit, elements (tombstones included)
+//    over capacity. Tables let it be changed at run time.
+//  - table_size(n): the capacity actually used when n slots are asked for.
+//  - next_size(size): the capacity to grow to from size.
+//  - position(h, size), next_position(hx, step, size): the home slot of hash h
+//    and the slot after hx in a probe sequence.
+//  - migration_step(): zero for tables to be rehashed in one go when they 
+//    grow. Otherwise the old elements are left where they are and moved to 
+//    the new table this many at a time, on every insertion.
+//Group probed tables only use the first and third (they always have power of
+//two capacities and map hashes on their own).
+
+
+//The original scheme: capacity is taken as requested and positions are hash
+//values modulo the capacity.
+
+struct modulo_growth
+{
+  static float max_load_factor(){return 0.5f;}
+  static std::size_t table_size(std::size_t n){return n < 2 ? 2 : n;}
+  static std::size_t next_size(std::size_t size){return 2 * size;}
+  static std::size_t migration_step(){return 0;}
+  static std::size_t position(std::size_t h, std::size_t size){return h % size;}
+  static std::size_t next_position(std::size_t hx, std::size_t step, std::size_t size)
+  {
+    return (hx + step) % size;
+  }
+};
+
+
+//Capacity is rounded up to a power of two. Positions come from the high bits
+//of the Fibonacci mixed hash and probing wraps around with a mask, so there 
+//is no division on the probe path. Steps are made odd, so double hashing still
+//visits every slot.
+
+struct power_of_two_growth
+{
+  static float max_load_factor(){return 0.5f;}
+  static std::size_t table_size(std::size_t n){return next_power_of_two(n < 2 ? 2 : n);}
+  static std::size_t next_size(std::size_t size){return 2 * size;}
+  static std::size_t migration_step(){return 0;}
+  static std::size_t position(std::size_t h, std::size_t size)
+  {
+    return fibonacci_mix(h) >> (sizeof(std::size_t) * CHAR_BIT - count_trailing_zeros(size));
+  }
+  static std::size_t next_position(std::size_t hx, std::size_t step, std::size_t size)
+  {
+    return (hx + (step | 1)) & (size - 1);
+  }
+};
+
+
+//Incremental resizing on top of another policy. Growing only allocates the 
+//new table; the elements of the old one follow, STEP per insertion, so no
+//single insertion pays for a whole rehash. Meanwhile lookups may have to 
+//search both tables. Doubling leaves at least as many insertions before the
+//next growth as there are elements to move, so a few per insertion are plenty.
+//Whatever is left when the new table fills up is moved at once.
+
+template <class growth_t, std::size_t STEP = 8>
+struct incremental_growth : growth_t
+{
+  static std::size_t migration_step(){return STEP;}
+};
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_GROWTH_H
@@ -28,6 +28,25 @@
 #ifndef HASHCOL_HASH_FUNCTION_H
 #define HASHCOL_HASH_FUNCTION_H
 
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include "config.h"
+
+#ifdef HASHCOL_HAS_STRING_VIEW
+  #include <string_view>
+#endif
+#ifdef HASHCOL_HAS_CXX11
+  #include <type_traits>
+#endif
+#if defined(_MSC_VER) && defined(_M_X64)
+  #include <intrin.h>
+#endif
+#if defined(HASHCOL_HAS_AVX2) || defined(HASHCOL_HAS_AVX512)
+  #include <immintrin.h>
+#endif
+
 
 HASHCOL_BEGIN_NAMESPACE
 
@@ -37,39 +56,413 @@ struct hash{};
 template <> 
 struct hash<short>
 {
-  std::size_t operator()(short x){return 16161 * x;}
+  std::size_t operator()(short x)const{return 16161 * x;}
 };
 
 template <> 
 struct hash<unsigned short>
 {
-  std::size_t operator()(unsigned short x){return 16161 * x;}
+  std::size_t operator()(unsigned short x)const{return 16161 * x;}
 };
 
 template <> 
 struct hash<int>
 {
-  std::size_t operator()(int x){return 16161 * x;}
+  std::size_t operator()(int x)const{return 16161 * std::size_t(x);}
 };
 
 template <> 
 struct hash<unsigned int>
 {
-  std::size_t operator()(unsigned int x){return 16161 * x;}
+  std::size_t operator()(unsigned int x)const{return 16161 * x;}
 };
 
 template <> 
 struct hash<long>
 {
-  std::size_t operator()(long x){return 16161 * x;}
+  std::size_t operator()(long x)const{return 16161 * std::size_t(x);}
 };
 
 template <> 
 struct hash<unsigned long>
 {
-  std::size_t operator()(unsigned long x){return 16161 * x;}
+  std::size_t operator()(unsigned long x)const{return 16161 * x;}
+};
+
+
+//Multiplicative (Fibonacci) mixing: multiplies by 2^w/phi so that every bit
+//of the hash affects the high bits of the result. Tables that take positions
+//from the high bits use it to survive weak hashes like the ones above.
+
+template <std::size_t bytes>
+struct fibonacci_multiplier{};
+
+template <>
+struct fibonacci_multiplier<4>
+{
+  static std::size_t value(){return 0x9E3779B9u;}
+};
+
+template <>
+struct fibonacci_multiplier<8>
+{
+  static std::size_t value(){return (std::size_t(0x9E3779B9u) << 16 << 16) | 0x7F4A7C15u;}
+};
+
+inline std::size_t fibonacci_mix(std::size_t h)
+{
+  return h * fibonacci_multiplier<sizeof(std::size_t)>::value();
+}
+
+
+//Byte ranges (strings) are hashed after wyhash (Wang Yi, public domain): 
+//64 bit words are multiplied into 128 bit products whose halves are xored
+//together. Long inputs go through three independent lanes 48 bytes at a time,
+//shorter ones 16 bytes at a time, and the last bytes are read as (possibly 
+//overlapping) words instead of one at a time. The result is 64 bits wide, 
+//truncated where std::size_t is narrower. Values depend on the byte order.
+
+typedef unsigned long long hash_word;
+
+inline hash_word make_word(unsigned int high, unsigned int low)
+{
+  return (hash_word(high) << 32) | low;
+}
+
+//a and b become the low and high halves of their product.
+inline void wide_multiply(hash_word& a, hash_word& b)
+{
+#if defined(__SIZEOF_INT128__)
+  __uint128_t r = static_cast<__uint128_t>(a) * b;
+  a = static_cast<hash_word>(r);
+  b = static_cast<hash_word>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  a = _umul128(a, b, &b);
+#else
+  hash_word ha = a >> 32, hb = b >> 32, la = a & 0xFFFFFFFFu, lb = b & 0xFFFFFFFFu;
+  hash_word hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+  hash_word t = ll + (hl << 32);
+  hash_word carry = t < ll;
+  hash_word lo = t + (lh << 32);
+  carry += lo < t;
+  a = lo;
+  b = hh + (hl >> 32) + (lh >> 32) + carry;
+#endif
+}
+inline hash_word multiply_mix(hash_word a, hash_word b)
+{
+  wide_multiply(a, b);
+  return a ^ b;
+}
+inline hash_word read_word64(const unsigned char* p)
+{
+  hash_word w;
+  std::memcpy(&w, p, 8);
+  return w;
+}
+inline hash_word read_word32(const unsigned char* p)
+{
+  unsigned int w;
+  std::memcpy(&w, p, 4);
+  return w;
+}
+
+inline std::size_t hash_bytes(const void* key, std::size_t len, hash_word seed = 0)
+{
+  const unsigned char* p = static_cast<const unsigned char*>(key);
+  const hash_word s0 = make_word(0xa0761d64u, 0x78bd642fu);
+  const hash_word s1 = make_word(0xe7037ed1u, 0xa0b428dbu);
+  seed ^= multiply_mix(seed ^ s0, s1);
+  hash_word a, b;
+  if (len <= 16)
+  {
+    if (len >= 4)
+    {
+      std::size_t d = (len >> 3) << 2; //0 or 4: the middle bytes of 8 to 16.
+      a = (read_word32(p) << 32) | read_word32(p + d);
+      b = (read_word32(p + len - 4) << 32) | read_word32(p + len - 4 - d);
+    }
+    else if (len > 0)
+    {
+      a = (hash_word(p[0]) << 16) | (hash_word(p[len >> 1]) << 8) | p[len - 1];
+      b = 0;
+    }
+    else a = b = 0;
+  }
+  else
+  {
+    std::size_t i = len;
+    if (i > 48)
+    {
+      const hash_word s2 = make_word(0x8ebc6af0u, 0x9c88c6e3u);
+      const hash_word s3 = make_word(0x589965ccu, 0x75374cc3u);
+      hash_word see1 = seed, see2 = seed;
+      do
+      {
+        seed = multiply_mix(read_word64(p) ^ s1, read_word64(p + 8) ^ seed);
+        see1 = multiply_mix(read_word64(p + 16) ^ s2, read_word64(p + 24) ^ see1);
+        see2 = multiply_mix(read_word64(p + 32) ^ s3, read_word64(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    for (; i > 16; i -= 16, p += 16)
+      seed = multiply_mix(read_word64(p) ^ s1, read_word64(p + 8) ^ seed);
+    a = read_word64(p + i - 16);
+    b = read_word64(p + i - 8);
+  }
+  a ^= s1;
+  b ^= seed;
+  wide_multiply(a, b);
+  return static_cast<std::size_t>(multiply_mix(a ^ s0 ^ len, b ^ s1));
+}
+
+
+//Strings. hash<std::string> is transparent: C strings (and string views) 
+//hash the same as the std::string with the same characters.
+
+template <>
+struct hash<std::string>
+{
+  typedef void is_transparent;
+  std::size_t operator()(const std::string& s)const{return hash_bytes(s.data(), s.size());}
+  std::size_t operator()(const char* s)const{return hash_bytes(s, std::strlen(s));}
+#ifdef HASHCOL_HAS_STRING_VIEW
+  std::size_t operator()(std::string_view s)const{return hash_bytes(s.data(), s.size());}
+#endif
+};
+
+//As SGI's, hashes the characters, not the pointer.
+template <>
+struct hash<const char*>
+{
+  std::size_t operator()(const char* s)const{return hash_bytes(s, std::strlen(s));}
+};
+
+#ifdef HASHCOL_HAS_STRING_VIEW
+template <>
+struct hash<std::string_view>
+{
+  typedef void is_transparent;
+  std::size_t operator()(std::string_view s)const{return hash_bytes(s.data(), s.size());}
+};
+#endif
+
+
+//Strong integer hashes, an alternative to hash<> for keys with patterns (the
+//multiplications above leave the low bits weak, and strided keys cluster).
+//Every bit of the key affects every bit of the hash. fmix_hash is the 
+//finalizer of MurmurHash3 (Austin Appleby), splitmix_hash the output function
+//of SplitMix64 (Steele, Lea and Flood), which does not map 0 to 0. Both take
+//any integral type, widened to 64 bits.
+
+//Both are two rounds of xor-shift and multiply.
+struct fmix64_mixer
+{
+  enum {SHIFT1 = 33, SHIFT2 = 33, SHIFT3 = 33};
+  static hash_word offset(){return 0;}
+  static hash_word multiplier1(){return make_word(0xff51afd7u, 0xed558ccdu);}
+  static hash_word multiplier2(){return make_word(0xc4ceb9feu, 0x1a85ec53u);}
 };
 
+struct splitmix64_mixer
+{
+  enum {SHIFT1 = 30, SHIFT2 = 27, SHIFT3 = 31};
+  static hash_word offset(){return make_word(0x9e3779b9u, 0x7f4a7c15u);}
+  static hash_word multiplier1(){return make_word(0xbf58476du, 0x1ce4e5b9u);}
+  static hash_word multiplier2(){return make_word(0x94d049bbu, 0x133111ebu);}
+};
+
+template <class mixer_t>
+inline hash_word mix_word(hash_word k)
+{
+  k += mixer_t::offset();
+  k = (k ^ (k >> mixer_t::SHIFT1)) * mixer_t::multiplier1();
+  k = (k ^ (k >> mixer_t::SHIFT2)) * mixer_t::multiplier2();
+  return k ^ (k >> mixer_t::SHIFT3);
+}
+
+template <class key_t>
+struct fmix_hash
+{
+  std::size_t operator()(key_t x)const
+  {
+    return static_cast<std::size_t>(mix_word<fmix64_mixer>(static_cast<hash_word>(x)));
+  }
+};
+
+template <class key_t>
+struct splitmix_hash
+{
+  std::size_t operator()(key_t x)const
+  {
+    return static_cast<std::size_t>(mix_word<splitmix64_mixer>(static_cast<hash_word>(x)));
+  }
+};
+
+
+//Hashes n keys into out. The mixers above do 64 bit keys 8 at a time with 
+//AVX-512, or 4 at a time with AVX2 (which has no 64 bit multiplication, so 
+//it is made of 32 bit ones); anything else is hashed one key at a time.
+
+template <class hasher_t, class key_t>
+void hash_batch(const hasher_t& h, const key_t* keys, std::size_t n, std::size_t* out)
+{
+  for (std::size_t i = 0; i < n; ++i) out[i] = h(keys[i]);
+}
+
+#if defined(HASHCOL_HAS_AVX512)
+
+//The zero masked shift only avoids a false uninitialized warning of GCC 12.
+inline __m512i shift_words(__m512i k, unsigned int n)
+{
+  return _mm512_maskz_srli_epi64(0xFF, k, n);
+}
+
+template <class mixer_t>
+inline __m512i mix_words(__m512i k)
+{
+  const __m512i m1 = _mm512_set1_epi64(static_cast<long long>(mixer_t::multiplier1()));
+  const __m512i m2 = _mm512_set1_epi64(static_cast<long long>(mixer_t::multiplier2()));
+  k = _mm512_add_epi64(k, _mm512_set1_epi64(static_cast<long long>(mixer_t::offset())));
+  k = _mm512_mullo_epi64(_mm512_xor_si512(k, shift_words(k, mixer_t::SHIFT1)), m1);
+  k = _mm512_mullo_epi64(_mm512_xor_si512(k, shift_words(k, mixer_t::SHIFT2)), m2);
+  return _mm512_xor_si512(k, shift_words(k, mixer_t::SHIFT3));
+}
+
+#elif defined(HASHCOL_HAS_AVX2)
+
+//Low 64 bits of a * m: a.lo * m.lo + ((a.hi * m.lo + a.lo * m.hi) << 32).
+inline __m256i multiply_words(__m256i a, hash_word m)
+{
+  const __m256i lo = _mm256_set1_epi64x(static_cast<long long>(m));
+  const __m256i hi = _mm256_set1_epi64x(static_cast<long long>(m >> 32));
+  __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), lo), 
+                                   _mm256_mul_epu32(a, hi));
+  return _mm256_add_epi64(_mm256_mul_epu32(a, lo), _mm256_slli_epi64(cross, 32));
+}
+
+template <class mixer_t>
+inline __m256i mix_words(__m256i k)
+{
+  k = _mm256_add_epi64(k, _mm256_set1_epi64x(static_cast<long long>(mixer_t::offset())));
+  k = multiply_words(_mm256_xor_si256(k, _mm256_srli_epi64(k, mixer_t::SHIFT1)), mixer_t::multiplier1());
+  k = multiply_words(_mm256_xor_si256(k, _mm256_srli_epi64(k, mixer_t::SHIFT2)), mixer_t::multiplier2());
+  return _mm256_xor_si256(k, _mm256_srli_epi64(k, mixer_t::SHIFT3));
+}
+
+#endif
+
+template <class mixer_t, class key_t>
+void mix_batch(const key_t* keys, std::size_t n, std::size_t* out)
+{
+  std::size_t i = 0;
+  if (sizeof(key_t) == 8 && sizeof(std::size_t) == 8)
+  {
+#if defined(HASHCOL_HAS_AVX512)
+    for (; i + 8 <= n; i += 8)
+      _mm512_storeu_si512(out + i, mix_words<mixer_t>(_mm512_loadu_si512(keys + i)));
+#elif defined(HASHCOL_HAS_AVX2)
+    for (; i + 4 <= n; i += 4)
+    {
+      __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), mix_words<mixer_t>(k));
+    }
+#endif
+  }
+  for (; i < n; ++i) 
+    out[i] = static_cast<std::size_t>(mix_word<mixer_t>(static_cast<hash_word>(keys[i])));
+}
+
+template <class key_t>
+void hash_batch(const fmix_hash<key_t>&, const key_t* keys, std::size_t n, std::size_t* out)
+{
+  mix_batch<fmix64_mixer>(keys, n, out);
+}
+
+template <class key_t>
+void hash_batch(const splitmix_hash<key_t>&, const key_t* keys, std::size_t n, std::size_t* out)
+{
+  mix_batch<splitmix64_mixer>(keys, n, out);
+}
+
+
+//Hashing categories tell tables whether to hash keys in blocks, with 
+//hash_batch(), when there are many of them at once.
+
+struct scalar_hashing_tag{};
+struct batch_hashing_tag{};
+
+template <class hasher_t>
+struct hashing_traits
+{
+  typedef scalar_hashing_tag category;
+};
+
+template <class key_t>
+struct hashing_traits<fmix_hash<key_t> >
+{
+  typedef batch_hashing_tag category;
+};
+
+template <class key_t>
+struct hashing_traits<splitmix_hash<key_t> >
+{
+  typedef batch_hashing_tag category;
+};
+
+
+//Whether tables keep the hash of every element next to it. It is checked 
+//before comparing keys, and reused when elements are rehashed or tables 
+//compared, so it pays for keys that are expensive to hash or compare: by
+//default, those that are not trivially copyable (before C++11, anything but
+//arithmetic types and pointers). Specialize it to decide otherwise.
+
+#ifdef HASHCOL_HAS_CXX11
+
+template <class key_t>
+struct store_hash
+{
+  enum {value = !std::is_trivially_copyable<key_t>::value};
+};
+
+#else
+
+template <class key_t>
+struct store_hash
+{
+  enum {value = true};
+};
+
+template <class key_t>
+struct store_hash<key_t*>
+{
+  enum {value = false};
+};
+
+#define HASHCOL_SCALAR_KEY(key_t) \
+  template <> struct store_hash<key_t>{enum {value = false};};
+
+HASHCOL_SCALAR_KEY(bool)
+HASHCOL_SCALAR_KEY(char)
+HASHCOL_SCALAR_KEY(signed char)
+HASHCOL_SCALAR_KEY(unsigned char)
+HASHCOL_SCALAR_KEY(wchar_t)
+HASHCOL_SCALAR_KEY(short)
+HASHCOL_SCALAR_KEY(unsigned short)
+HASHCOL_SCALAR_KEY(int)
+HASHCOL_SCALAR_KEY(unsigned int)
+HASHCOL_SCALAR_KEY(long)
+HASHCOL_SCALAR_KEY(unsigned long)
+HASHCOL_SCALAR_KEY(float)
+HASHCOL_SCALAR_KEY(double)
+HASHCOL_SCALAR_KEY(long double)
+
+#undef HASHCOL_SCALAR_KEY
+
+#endif
+
 HASHCOL_END_NAMESPACE
 
 #endif //HASHCOL_HASH_FUNCTION_H
@@ -30,8 +30,14 @@
 
 
 #include "hash_table.h"
+#include "mapped_hash_table.h"
+#include "frozen_hash_map.h"
 #include "increment.h"
 
+#ifdef HASHCOL_HAS_CXX11
+  #include <tuple>
+#endif
+
 
 HASHCOL_BEGIN_NAMESPACE
 
@@ -42,11 +48,12 @@ template <
   class hash_fcn_t = hash<key_t>, 
   class increment_t = unit_increment<key_t>,
   class equal_key_t = std::equal_to<key_t>, 
-  class alloc_t = std::allocator<std::pair<key_t, value_t> > >
+  class alloc_t = std::allocator<std::pair<key_t, value_t> >,
+  class growth_t = modulo_growth>
 class hash_map 
 {
 private:
-  typedef hash_map<key_t, value_t, hash_fcn_t, increment_t, equal_key_t, alloc_t> Self;
+  typedef hash_map<key_t, value_t, hash_fcn_t, increment_t, equal_key_t, alloc_t, growth_t> Self;
 
   //typedef std::pair<const key_t, value_t> Map_pair; 
   typedef std::pair<key_t, value_t> Map_pair;
@@ -57,10 +64,17 @@ private:
     increment_t,
     equal_key_t,
     select1st<Map_pair>,
-    alloc_t> HT; 
+    alloc_t,
+    growth_t> HT; 
 
   HT underlying_;
 
+  struct DefaultElement
+  {
+    template <class K>
+    Map_pair operator()(const K& k)const{return Map_pair(key_t(k), value_t());}
+  };
+
 public:
   typedef typename HT::key_type key_type;
   typedef value_t data_type;
@@ -112,11 +126,75 @@ public:
   {
     return this->underlying_.insert_unique(x);
   }  
+#ifdef HASHCOL_HAS_CXX11
+  std::pair<iterator, bool> insert(value_type&& x)
+  {
+    return this->underlying_.insert_unique(std::move(x));
+  }
+  template <class... args_t>
+  std::pair<iterator, bool> emplace(args_t&&... args)
+  {
+    return this->underlying_.insert_unique(value_type(std::forward<args_t>(args)...));
+  }
+  //The mapped value is only built from args if k is not in the map.
+  template <class... args_t>
+  std::pair<iterator, bool> try_emplace(const key_type& k, args_t&&... args)
+  {
+    return this->underlying_.insert_unique_key(k, [&](const key_type&)
+    {
+      return value_type(std::piecewise_construct, std::forward_as_tuple(k), 
+                        std::forward_as_tuple(std::forward<args_t>(args)...));
+    });
+  }
+  template <class... args_t>
+  std::pair<iterator, bool> try_emplace(key_type&& k, args_t&&... args)
+  {
+    return this->underlying_.insert_unique_key(k, [&](const key_type&)
+    {
+      return value_type(std::piecewise_construct, std::forward_as_tuple(std::move(k)), 
+                        std::forward_as_tuple(std::forward<args_t>(args)...));
+    });
+  }
+  template <class data_t>
+  std::pair<iterator, bool> insert_or_assign(const key_type& k, data_t&& d)
+  {
+    std::pair<iterator, bool> r = this->try_emplace(k, std::forward<data_t>(d));
+    if (!r.second) r.first->second = std::forward<data_t>(d);
+    return r;
+  }
+  template <class data_t>
+  std::pair<iterator, bool> insert_or_assign(key_type&& k, data_t&& d)
+  {
+    std::pair<iterator, bool> r = this->try_emplace(std::move(k), std::forward<data_t>(d));
+    if (!r.second) r.first->second = std::forward<data_t>(d);
+    return r;
+  }
+#endif
   template <class iterator_t>
   void insert(iterator_t b, iterator_t e)
   {
     this->underlying_.insert_unique(b, e);
   }
+  //Replaces the elements with those of [b, e), in tasks that run may spread
+  //over threads (parallel_build.h).
+  template <class random_iterator_t, class runner_t>
+  void build(random_iterator_t b, random_iterator_t e, runner_t& run)
+  {
+    this->underlying_.build(b, e, true, run);
+  }
+
+  //Calls f on the elements in part i of n of the slots. The parts can be 
+  //visited on different threads (parallel_algorithm.h).
+  template <class function_t>
+  function_t for_each_part(size_type i, size_type n, function_t f)
+  {
+    return this->underlying_.for_each_part(i, n, f);
+  }
+  template <class function_t>
+  function_t for_each_part(size_type i, size_type n, function_t f)const
+  {
+    return this->underlying_.for_each_part(i, n, f);
+  }
 
   void erase(iterator it){this->underlying_.erase(it);}  
   void erase(iterator b, iterator e){this->underlying_.erase(b, e);}
@@ -124,37 +202,128 @@ public:
 
   iterator find(const key_type& k){return this->underlying_.find(k);}
   const_iterator find(const key_type& k)const{return this->underlying_.find(k);}
+  //find() and whether found, for each key in [b, e). Neighbouring lookups
+  //overlap their cache misses.
+  template <class forward_iterator_t, class output_iterator_t>
+  output_iterator_t find_many(forward_iterator_t b, forward_iterator_t e, output_iterator_t out)
+  {
+    return this->underlying_.find_many(b, e, out);
+  }
+  template <class forward_iterator_t, class output_iterator_t>
+  output_iterator_t find_many(forward_iterator_t b, forward_iterator_t e, output_iterator_t out)const
+  {
+    return this->underlying_.find_many(b, e, out);
+  }
+  template <class forward_iterator_t, class output_iterator_t>
+  output_iterator_t contains_many(forward_iterator_t b, forward_iterator_t e, output_iterator_t out)const
+  {
+    return this->underlying_.contains_many(b, e, out);
+  }
+
+  //Heterogeneous lookups, if both hasher and key_equal are transparent.
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, size_type>::type 
+  erase(const K& k){return this->underlying_.erase(k);}
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, iterator>::type 
+  find(const K& k){return this->underlying_.find(k);}
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, const_iterator>::type 
+  find(const K& k)const{return this->underlying_.find(k);}
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, size_type>::type 
+  count(const K& k)const{return this->underlying_.count(k);}
 
   size_type size()const{return this->underlying_.size();}
   size_type max_size()const{return this->underlying_.max_size();}
   size_type bucket_count()const{return this->underlying_.bucket_count();}
   bool empty()const{return this->underlying_.empty();}
-  void resize(size_type n){this->underlying_.resize_unique(n);}
+  void resize(size_type n){this->underlying_.resize(n);}
   void clear(){this->underlying_.clear();}
+  void compact(){this->underlying_.compact();}
+  float load_factor()const{return this->underlying_.load_factor();}
+  float max_load_factor()const{return this->underlying_.max_load_factor();}
+  void max_load_factor(float z){this->underlying_.max_load_factor(z);}
+  void reserve(size_type n){this->underlying_.reserve(n);}
+  void rehash(size_type n){this->underlying_.rehash(n);}
+  template <class runner_t>
+  void rehash(size_type n, runner_t& run){this->underlying_.rehash(n, run);}
+  table_statistics statistics()const{return this->underlying_.statistics();}
+  template <class input_iterator_t>
+  table_statistics statistics(input_iterator_t b, input_iterator_t e)const
+  {
+    return this->underlying_.statistics(b, e);
+  }
+
+  //Snapshots (snapshot.h): save() writes the slots to a file, open_mapped()
+  //maps one into a read-only view that looks keys up in place.
+  typedef mapped_hash_table__<HT> mapped_view;
+  bool save(const char* path)const
+  {
+#ifdef HASHCOL_HAS_CXX11
+    static_assert(std::is_trivially_copyable<key_t>::value && std::is_trivially_copyable<value_t>::value,
+                  "snapshots need trivially copyable elements");
+#endif
+    return this->underlying_.save(path);
+  }
+  static bool open_mapped(const char* path, mapped_view& view){return view.open(path);}
+  static bool open_mapped(const char* path, mapped_view& view, const hasher& h)
+  {
+    return view.open(path, h);
+  }
+  static bool open_mapped(const char* path, mapped_view& view, const hasher& h, const key_equal& eq)
+  {
+    return view.open(path, h, eq);
+  }
+
+  //An immutable copy over a minimal perfect hash (frozen_hash_table.h). The
+  //runner spreads the build over threads (parallel_build.h).
+  typedef frozen_hash_map<key_t, value_t, hash_fcn_t, equal_key_t, alloc_t> frozen_type;
+  frozen_type freeze()const
+  {
+    return frozen_type(this->begin(), this->end(), this->hash_funct(), this->key_eq());
+  }
+  template <class runner_t>
+  frozen_type freeze(runner_t& run)const
+  {
+    frozen_type f(this->hash_funct(), this->key_eq());
+    f.build(this->begin(), this->end(), run);
+    return f;
+  }
   size_type count(const key_type& k)const{return this->underlying_.count(k);}
 
+  //A single lookup, the element is only made if k is not there.
   data_type& operator[](const key_type& k)
   {
-    iterator it = this->underlying_.find(k);
-    if (it == this->underlying_.end())
-      return (*((this->insert(value_type(k, data_type()))).first)).second;
-    return it->second;
+    return this->underlying_.insert_unique_key(k, DefaultElement()).first->second;
+  }
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, data_type&>::type
+  operator[](const K& k)
+  {
+    return this->underlying_.insert_unique_key(k, DefaultElement()).first->second;
+  }
+#ifdef HASHCOL_HAS_CXX11
+  data_type& operator[](key_type&& k)
+  {
+    return this->try_emplace(std::move(k)).first->second;
   }
+#endif
 
   iterator begin(){return this->underlying_.begin();}
   iterator end(){return this->underlying_.end();}
   const_iterator begin()const{return this->underlying_.begin();}
   const_iterator end()const{return this->underlying_.end();}
 
-  template <class K, class V, class H, class I, class E, class A>
+  template <class K, class V, class H, class I, class E, class A, class P>
   friend bool
-  operator==(const hash_map<K, V, H, I, E, A>& l, const hash_map<K, V, H, I, E, A>& r);
+  operator==(const hash_map<K, V, H, I, E, A, P>& l, const hash_map<K, V, H, I, E, A, P>& r);
 
 };
 
-template <class K, class V, class H, class I, class E, class A>
+template <class K, class V, class H, class I, class E, class A, class P>
 bool
-operator==(const hash_map<K, V, H, I, E, A>& l, const hash_map<K, V, H, I, E, A>& r)
+operator==(const hash_map<K, V, H, I, E, A, P>& l, const hash_map<K, V, H, I, E, A, P>& r)
 {
   return l.underlying_ == r.underlying_;
 }
@@ -41,11 +41,12 @@ template <
   class hash_fcn_t = hash<value_t>, 
   class increment_t = unit_increment<value_t>,
   class equal_key_t = std::equal_to<value_t>, 
-  class alloc_t = std::allocator<value_t> >
+  class alloc_t = std::allocator<value_t>,
+  class growth_t = modulo_growth>
 class hash_multiset 
 {
 private:
-  typedef hash_multiset<value_t, hash_fcn_t, increment_t, equal_key_t, alloc_t> Self;
+  typedef hash_multiset<value_t, hash_fcn_t, increment_t, equal_key_t, alloc_t, growth_t> Self;
 
   typedef hash_table__<
     value_t,
@@ -54,7 +55,8 @@ private:
     increment_t,
     equal_key_t,
     identity<value_t>,
-    alloc_t> HT; 
+    alloc_t,
+    growth_t> HT; 
 
   HT underlying_;
 
@@ -70,6 +72,8 @@ public:
   typedef typename HT::allocator allocator;
   typedef typename HT::iterator iterator;
   typedef typename HT::const_iterator const_iterator;
+  typedef typename HT::equal_iterator equal_iterator;
+  typedef typename HT::const_equal_iterator const_equal_iterator;
   typedef typename HT::difference_type difference_type;
   
   hash_multiset(size_type max = 100):
@@ -107,12 +111,43 @@ public:
   iterator insert(const value_type& x)
   {
     return this->underlying_.insert_equal(x);
-  }  
+  }
+#ifdef HASHCOL_HAS_CXX11
+  iterator insert(value_type&& x)
+  {
+    return this->underlying_.insert_equal(std::move(x));
+  }
+  template <class... args_t>
+  iterator emplace(args_t&&... args)
+  {
+    return this->underlying_.insert_equal(value_type(std::forward<args_t>(args)...));
+  }
+#endif  
   template <class iterator_t>
   void insert(iterator_t b, iterator_t e)
   {
     this->underlying_.insert_equal(b, e);
   }
+  //Replaces the elements with those of [b, e), in tasks that run may spread
+  //over threads (parallel_build.h).
+  template <class random_iterator_t, class runner_t>
+  void build(random_iterator_t b, random_iterator_t e, runner_t& run)
+  {
+    this->underlying_.build(b, e, false, run);
+  }
+
+  //Calls f on the elements in part i of n of the slots. The parts can be 
+  //visited on different threads (parallel_algorithm.h).
+  template <class function_t>
+  function_t for_each_part(size_type i, size_type n, function_t f)
+  {
+    return this->underlying_.for_each_part(i, n, f);
+  }
+  template <class function_t>
+  function_t for_each_part(size_type i, size_type n, function_t f)const
+  {
+    return this->underlying_.for_each_part(i, n, f);
+  }
 
   void erase(iterator it){this->underlying_.erase(it);}  
   void erase(iterator b, iterator e){this->underlying_.erase(b, e);}
@@ -120,28 +155,92 @@ public:
 
   iterator find(const key_type& k){return this->underlying_.find(k);}
   const_iterator find(const key_type& k)const{return this->underlying_.find(k);}
+  //find() and whether found, for each key in [b, e). Neighbouring lookups
+  //overlap their cache misses.
+  template <class forward_iterator_t, class output_iterator_t>
+  output_iterator_t find_many(forward_iterator_t b, forward_iterator_t e, output_iterator_t out)
+  {
+    return this->underlying_.find_many(b, e, out);
+  }
+  template <class forward_iterator_t, class output_iterator_t>
+  output_iterator_t find_many(forward_iterator_t b, forward_iterator_t e, output_iterator_t out)const
+  {
+    return this->underlying_.find_many(b, e, out);
+  }
+  template <class forward_iterator_t, class output_iterator_t>
+  output_iterator_t contains_many(forward_iterator_t b, forward_iterator_t e, output_iterator_t out)const
+  {
+    return this->underlying_.contains_many(b, e, out);
+  }
+
+  //Heterogeneous lookups, if both hasher and key_equal are transparent.
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, size_type>::type 
+  erase(const K& k){return this->underlying_.erase(k);}
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, iterator>::type 
+  find(const K& k){return this->underlying_.find(k);}
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, const_iterator>::type 
+  find(const K& k)const{return this->underlying_.find(k);}
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, size_type>::type 
+  count(const K& k)const{return this->underlying_.count(k);}
 
   size_type size()const{return this->underlying_.size();}
   size_type max_size()const{return this->underlying_.max_size();}
   size_type bucket_count()const{return this->underlying_.bucket_count();}
   bool empty()const{return this->underlying_.empty();}
-  void resize(size_type n){this->underlying_.resize_equal(n);}
+  void resize(size_type n){this->underlying_.resize(n);}
   void clear(){this->underlying_.clear();}
+  void compact(){this->underlying_.compact();}
+  float load_factor()const{return this->underlying_.load_factor();}
+  float max_load_factor()const{return this->underlying_.max_load_factor();}
+  void max_load_factor(float z){this->underlying_.max_load_factor(z);}
+  void reserve(size_type n){this->underlying_.reserve(n);}
+  void rehash(size_type n){this->underlying_.rehash(n);}
+  template <class runner_t>
+  void rehash(size_type n, runner_t& run){this->underlying_.rehash(n, run);}
+  table_statistics statistics()const{return this->underlying_.statistics();}
+  template <class input_iterator_t>
+  table_statistics statistics(input_iterator_t b, input_iterator_t e)const
+  {
+    return this->underlying_.statistics(b, e);
+  }
   size_type count(const key_type& k)const{return this->underlying_.count(k);}
+  //The elements with key k, visited along its probe sequence.
+  std::pair<equal_iterator, equal_iterator> equal_range(const key_type& k)
+  {
+    return this->underlying_.equal_range(k);
+  }
+  std::pair<const_equal_iterator, const_equal_iterator> equal_range(const key_type& k)const
+  {
+    return this->underlying_.equal_range(k);
+  }
+  template <class function_t>
+  function_t for_each_equal(const key_type& k, function_t f)
+  {
+    return this->underlying_.for_each_equal(k, f);
+  }
+  template <class function_t>
+  function_t for_each_equal(const key_type& k, function_t f)const
+  {
+    return this->underlying_.for_each_equal(k, f);
+  }
 
   iterator begin(){return this->underlying_.begin();}
   iterator end(){return this->underlying_.end();}
   const_iterator begin()const{return this->underlying_.begin();}
   const_iterator end()const{return this->underlying_.end();}
 
-  template <class V, class H, class I, class E, class A>
+  template <class V, class H, class I, class E, class A, class P>
   friend bool
-  operator==(const hash_multiset<V, H, I, E, A>& l, const hash_multiset<V, H, I, E, A>& r);
+  operator==(const hash_multiset<V, H, I, E, A, P>& l, const hash_multiset<V, H, I, E, A, P>& r);
 };
 
-template <class V, class H, class I, class E, class A>
+template <class V, class H, class I, class E, class A, class P>
 bool
-operator==(const hash_multiset<V, H, I, E, A>& l, const hash_multiset<V, H, I, E, A>& r)
+operator==(const hash_multiset<V, H, I, E, A, P>& l, const hash_multiset<V, H, I, E, A, P>& r)
 {
   return l.underlying_ == r.underlying_;
 }
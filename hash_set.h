@@ -30,6 +30,8 @@
 
 
 #include "hash_table.h"
+#include "mapped_hash_table.h"
+#include "frozen_hash_set.h"
 #include "increment.h"
 
 
@@ -41,11 +43,12 @@ template <
   class hash_fcn_t = hash<value_t>, 
   class increment_t = unit_increment<value_t>,
   class equal_key_t = std::equal_to<value_t>, 
-  class alloc_t = std::allocator<value_t> >
+  class alloc_t = std::allocator<value_t>,
+  class growth_t = modulo_growth>
 class hash_set 
 {
 private:
-  typedef hash_set<value_t, hash_fcn_t, increment_t, equal_key_t, alloc_t> Self;
+  typedef hash_set<value_t, hash_fcn_t, increment_t, equal_key_t, alloc_t, growth_t> Self;
 
   typedef hash_table__<
     value_t,
@@ -54,7 +57,8 @@ private:
     increment_t,
     equal_key_t,
     identity<value_t>,
-    alloc_t> HT; 
+    alloc_t,
+    growth_t> HT; 
 
   HT underlying_;
 
@@ -107,12 +111,43 @@ public:
   std::pair<iterator, bool> insert(const value_type& x)
   {
     return this->underlying_.insert_unique(x);
-  }  
+  }
+#ifdef HASHCOL_HAS_CXX11
+  std::pair<iterator, bool> insert(value_type&& x)
+  {
+    return this->underlying_.insert_unique(std::move(x));
+  }
+  template <class... args_t>
+  std::pair<iterator, bool> emplace(args_t&&... args)
+  {
+    return this->underlying_.insert_unique(value_type(std::forward<args_t>(args)...));
+  }
+#endif  
   template <class iterator_t>
   void insert(iterator_t b, iterator_t e)
   {
     this->underlying_.insert_unique(b, e);
   }
+  //Replaces the elements with those of [b, e), in tasks that run may spread
+  //over threads (parallel_build.h).
+  template <class random_iterator_t, class runner_t>
+  void build(random_iterator_t b, random_iterator_t e, runner_t& run)
+  {
+    this->underlying_.build(b, e, true, run);
+  }
+
+  //Calls f on the elements in part i of n of the slots. The parts can be 
+  //visited on different threads (parallel_algorithm.h).
+  template <class function_t>
+  function_t for_each_part(size_type i, size_type n, function_t f)
+  {
+    return this->underlying_.for_each_part(i, n, f);
+  }
+  template <class function_t>
+  function_t for_each_part(size_type i, size_type n, function_t f)const
+  {
+    return this->underlying_.for_each_part(i, n, f);
+  }
 
   void erase(iterator it){this->underlying_.erase(it);}  
   void erase(iterator b, iterator e){this->underlying_.erase(b, e);}
@@ -120,13 +155,94 @@ public:
 
   iterator find(const key_type& k){return this->underlying_.find(k);}
   const_iterator find(const key_type& k)const{return this->underlying_.find(k);}
+  //find() and whether found, for each key in [b, e). Neighbouring lookups
+  //overlap their cache misses.
+  template <class forward_iterator_t, class output_iterator_t>
+  output_iterator_t find_many(forward_iterator_t b, forward_iterator_t e, output_iterator_t out)
+  {
+    return this->underlying_.find_many(b, e, out);
+  }
+  template <class forward_iterator_t, class output_iterator_t>
+  output_iterator_t find_many(forward_iterator_t b, forward_iterator_t e, output_iterator_t out)const
+  {
+    return this->underlying_.find_many(b, e, out);
+  }
+  template <class forward_iterator_t, class output_iterator_t>
+  output_iterator_t contains_many(forward_iterator_t b, forward_iterator_t e, output_iterator_t out)const
+  {
+    return this->underlying_.contains_many(b, e, out);
+  }
+
+  //Heterogeneous lookups, if both hasher and key_equal are transparent.
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, size_type>::type 
+  erase(const K& k){return this->underlying_.erase(k);}
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, iterator>::type 
+  find(const K& k){return this->underlying_.find(k);}
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, const_iterator>::type 
+  find(const K& k)const{return this->underlying_.find(k);}
+  template <class K>
+  typename transparent_lookup<hasher, key_equal, K, size_type>::type 
+  count(const K& k)const{return this->underlying_.count(k);}
 
   size_type size()const{return this->underlying_.size();}
   size_type max_size()const{return this->underlying_.max_size();}
   size_type bucket_count()const{return this->underlying_.bucket_count();}
   bool empty()const{return this->underlying_.empty();}
-  void resize(size_type n){this->underlying_.resize_unique(n);}
+  void resize(size_type n){this->underlying_.resize(n);}
   void clear(){this->underlying_.clear();}
+  void compact(){this->underlying_.compact();}
+  float load_factor()const{return this->underlying_.load_factor();}
+  float max_load_factor()const{return this->underlying_.max_load_factor();}
+  void max_load_factor(float z){this->underlying_.max_load_factor(z);}
+  void reserve(size_type n){this->underlying_.reserve(n);}
+  void rehash(size_type n){this->underlying_.rehash(n);}
+  template <class runner_t>
+  void rehash(size_type n, runner_t& run){this->underlying_.rehash(n, run);}
+  table_statistics statistics()const{return this->underlying_.statistics();}
+  template <class input_iterator_t>
+  table_statistics statistics(input_iterator_t b, input_iterator_t e)const
+  {
+    return this->underlying_.statistics(b, e);
+  }
+
+  //Snapshots (snapshot.h): save() writes the slots to a file, open_mapped()
+  //maps one into a read-only view that looks keys up in place.
+  typedef mapped_hash_table__<HT> mapped_view;
+  bool save(const char* path)const
+  {
+#ifdef HASHCOL_HAS_CXX11
+    static_assert(std::is_trivially_copyable<value_t>::value, 
+                  "snapshots need trivially copyable elements");
+#endif
+    return this->underlying_.save(path);
+  }
+  static bool open_mapped(const char* path, mapped_view& view){return view.open(path);}
+  static bool open_mapped(const char* path, mapped_view& view, const hasher& h)
+  {
+    return view.open(path, h);
+  }
+  static bool open_mapped(const char* path, mapped_view& view, const hasher& h, const key_equal& eq)
+  {
+    return view.open(path, h, eq);
+  }
+
+  //An immutable copy over a minimal perfect hash (frozen_hash_table.h). The
+  //runner spreads the build over threads (parallel_build.h).
+  typedef frozen_hash_set<value_t, hash_fcn_t, equal_key_t, alloc_t> frozen_type;
+  frozen_type freeze()const
+  {
+    return frozen_type(this->begin(), this->end(), this->hash_funct(), this->key_eq());
+  }
+  template <class runner_t>
+  frozen_type freeze(runner_t& run)const
+  {
+    frozen_type f(this->hash_funct(), this->key_eq());
+    f.build(this->begin(), this->end(), run);
+    return f;
+  }
   size_type count(const key_type& k)const{return this->underlying_.count(k);}
 
   iterator begin(){return this->underlying_.begin();}
@@ -134,14 +250,14 @@ public:
   const_iterator begin()const{return this->underlying_.begin();}
   const_iterator end()const{return this->underlying_.end();}
 
-  template <class V, class H, class I, class E, class A>
+  template <class V, class H, class I, class E, class A, class P>
   friend bool
-  operator==(const hash_set<V, H, I, E, A>& l, const hash_set<V, H, I, E, A>& r);
+  operator==(const hash_set<V, H, I, E, A, P>& l, const hash_set<V, H, I, E, A, P>& r);
 };
 
-template <class V, class H, class I, class E, class A>
+template <class V, class H, class I, class E, class A, class P>
 bool
-operator==(const hash_set<V, H, I, E, A>& l, const hash_set<V, H, I, E, A>& r)
+operator==(const hash_set<V, H, I, E, A, P>& l, const hash_set<V, H, I, E, A, P>& r)
 {
   return l.underlying_ == r.underlying_;
 }
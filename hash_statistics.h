@@ -0,0 +1,132 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef HASHCOL_HASH_STATISTICS_H
+#define HASHCOL_HASH_STATISTICS_H
+
+#include <cstddef>
+#include <vector>
+
+#include "config.h"
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+//How often each length occurs (probe sequences, clusters...).
+
+class length_histogram
+{
+public:
+  length_histogram():counts_(),total_(0),sum_(0){}
+
+  void add(std::size_t length)
+  {
+    if (length >= this->counts_.size()) this->counts_.resize(length + 1, 0);
+    ++this->counts_[length];
+    ++this->total_;
+    this->sum_ += length;
+  }
+
+  std::size_t count()const{return this->total_;}
+  //Number of samples of length n.
+  std::size_t count(std::size_t n)const{return n < this->counts_.size() ? this->counts_[n] : 0;}
+  std::size_t max()const{return this->counts_.empty() ? 0 : this->counts_.size() - 1;}
+  double mean()const{return this->total_ == 0 ? 0.0 : double(this->sum_) / this->total_;}
+  //Smallest length at least a fraction p (0 to 1) of the samples do not exceed.
+  std::size_t percentile(double p)const
+  {
+    double seen = 0;
+    for (std::size_t n = 0; n < this->counts_.size(); ++n)
+    {
+      seen += this->counts_[n];
+      if (seen >= p * this->total_) return n;
+    }
+    return this->max();
+  }
+
+private:
+  std::vector<std::size_t> counts_;
+  std::size_t total_;
+  std::size_t sum_;
+};
+
+
+//What hash_table__::statistics() finds out about a table. Probe lengths count
+//the slots a lookup visits (groups, with group probing), the one it stops at
+//included: a key found in its home slot takes 1. Clusters are maximal runs of
+//slots that are not empty (tombstones do not end them). Home buckets are
+//slots, or groups with group probing; the chi-square of their occupancy 
+//against a uniform spread should be close to the degrees of freedom for a 
+//good hash function (uniformity() close to 1), and grows with clustering of 
+//home positions.
+
+struct table_statistics
+{
+  std::size_t buckets_;
+  std::size_t elements_;
+  std::size_t tombstones_;
+  length_histogram hits_; //Lookups of the keys in the table, one per element.
+  length_histogram misses_; //Lookups of the absent keys of a sample.
+  length_histogram clusters_;
+  double chi_square_;
+  std::size_t degrees_of_freedom_;
+
+  table_statistics():
+    buckets_(0),elements_(0),tombstones_(0),chi_square_(0),degrees_of_freedom_(0){}
+
+  double load_factor()const{return this->buckets_ == 0 ? 0.0 : double(this->elements_) / this->buckets_;}
+  double tombstone_density()const{return this->buckets_ == 0 ? 0.0 : double(this->tombstones_) / this->buckets_;}
+  double uniformity()const
+  {
+    return this->degrees_of_freedom_ == 0 ? 0.0 : this->chi_square_ / this->degrees_of_freedom_;
+  }
+};
+
+
+//Chi-square of bucket occupancy against the uniform spread of the same 
+//number of elements.
+
+inline double occupancy_chi_square(const std::vector<std::size_t>& occupancy)
+{
+  std::size_t n = 0;
+  for (std::size_t i = 0; i < occupancy.size(); ++i) n += occupancy[i];
+  if (n == 0) return 0.0;
+  double expected = double(n) / occupancy.size();
+  double chi = 0;
+  for (std::size_t i = 0; i < occupancy.size(); ++i)
+  {
+    double d = occupancy[i] - expected;
+    chi += d * d / expected;
+  }
+  return chi;
+}
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_HASH_STATISTICS_H
@@ -33,12 +33,24 @@
 #include <vector>
 #include <memory>
 #include <cstddef>
+#include <cstring>
+#include <climits>
+#include <cmath>
 #include <algorithm>
+#include <iterator>
+#include <typeinfo>
 
 #include "config.h"
+#include "bit_ops.h"
 #include "hash_function.h"
+#include "increment.h"
+#include "growth.h"
 #include "identity.h"
 #include "constness_traits.h"
+#include "control_group.h"
+#include "transparency.h"
+#include "snapshot.h"
+#include "hash_statistics.h"
 
 
 HASHCOL_BEGIN_NAMESPACE
@@ -50,9 +62,11 @@ NOTES:
   hash_set, and hash_multiset, which have interface similar to the corresponding 
   (non-standard) SGI implementations. However, both invariants of concept 
   Associative Container are not met. In a open addressing hash implementation I 
-  do not think it is possible to provide contiguos storage - that is why expression
-  equal_range is not implemented. Furthermore, I need assignment of pair with
-  constant keys for immutability of keys (in the map types), which is not possible. 
+  do not think it is possible to provide contiguos storage - that is why 
+  equal_range returns a range of its own iterator type, which steps from 
+  match to match along the probe sequence of the key. Furthermore, I need 
+  assignment of pair with constant keys for immutability of keys (in the map
+  types), which is not possible. 
   An alternative solution would be to construct a pair like interface class 
   with an assignment operator that meets this requirement. I have not done it yet.
 
@@ -62,10 +76,72 @@ NOTES:
   is the second hash function in the case of double hashing) for integral types.
   One might need to write her own.
 
+  - hash<> multiplies integers by a constant, which is fast but leaves patterns
+  in the keys (strides, low bits) in the hash. fmix_hash and splitmix_hash 
+  mix every bit. Range insertion hashes their keys in blocks, with AVX2 or 
+  AVX-512 when the compiler targets them (hash_batch() in hash_function.h).
+
+  - A third strategy, group probing (increment_t = group_probing<key_t>), keeps
+  one control byte per slot in a separate array and scans them 16 at a time
+  (SSE2 when available), in the spirit of Google's swiss tables. Keys are only
+  compared when the control byte matches 7 bits of the hash, so lookups rarely
+  touch elements other than the one they are after. Capacity is kept a power
+  of two in this mode.
+
+  - Robin Hood hashing (increment_t = robin_hood_probing<key_t>) is linear 
+  probing where an insertion displaces elements that are closer to their home
+  slot than the new one, which keeps probe lengths even. Lookups for absent
+  keys stop as soon as they meet an element closer to its home than they are.
+  Erasure shifts the rest of the cluster one slot back, so it never leaves a
+  tombstone, but it moves elements: erasing invalidates iterators to the 
+  elements that follow in the same cluster.
+
+  - Template argument growth_t decides capacities, the default load limit and
+  the growth factor, and maps hash values into the table (growth.h). The load
+  limit can be changed with max_load_factor(), and reserve()/rehash() resize
+  the table in a single step. modulo_growth is the original behavior. power_of_two_growth
+  rounds capacities to powers of two and takes positions from the high bits of
+  the Fibonacci mixed hash, which removes the division from every probe and 
+  tolerates weak hash functions. It also makes double hashing steps odd, as a 
+  step sharing a factor with the capacity would only visit part of the table.
+  incremental_growth<P> spreads the rehash over the insertions that follow a
+  growth: until the old table is drained, lookups search both, and iteration
+  goes through the old table first. Every insertion moves some elements, so
+  it invalidates iterators into the old table.
+
+  - Slots of keys that are expensive to hash or compare (store_hash<key_t>,
+  by default those that are not trivially copyable) also keep the hash of 
+  their element. Lookups compare it before the keys, and growth, compaction
+  and table comparison use it instead of calling the hasher again.
+
   - Elements of the hash table are never erased. Instead, they are just marked as
   unavailable. Actually removing the element is ok for linear probing (one just 
   needs to correct position of elements to the right of the erased element). 
   However, for double hashing there is no obvious equivalent implementation.
+  With group probing a slot does become empty again when its group still has
+  an empty slot, since no probe sequence goes past such a group.
+  Unavailable slots still count towards the load. When they make up most of
+  it, an insertion that would expand the table rehashes it in place at the 
+  same size instead, and compact() does the same on request.
+
+  - Lookups (find, count, erase, and insertion by key) are templates on the
+  key type, so that they can be given anything the hasher and key comparison
+  take. The containers only pass on other types than key_type if both are
+  transparent (transparency.h), e.g. to look a string key up from a const 
+  char* without making a string. Double hashing increments must take them
+  too.
+
+  - statistics() reports probe lengths of hits and misses, cluster lengths, 
+  how evenly the hash spreads home positions (chi-square) and tombstones, to
+  compare hash functions and probing strategies on real keys 
+  (hash_statistics.h, tools/hash_analyze.cpp).
+
+  - find_many() and contains_many() look keys up a block at a time: hash
+  them all, prefetch where their probes start (for group probing, also the
+  first matching slot), then probe. On tables larger than the cache the
+  misses of a block overlap instead of stalling one lookup after the other.
+  Range insertion works the same way, after making room for the whole range
+  at once when it is a forward range.
 
   - Functions are defined inside the class definition just for simplicity.
 
@@ -73,6 +149,178 @@ NOTES:
 
 ***********************************************************************************/
 
+//Elements change place when the table is rehashed or reorganized. Swapping
+//lets the payload follow them (strings, vectors...) without being copied. 
+//std::swap on a pair copies in C++98, so pairs are swapped member by member.
+template <class T>
+inline void swap_values(T& a, T& b)
+{
+  using std::swap;
+  swap(a, b);
+}
+template <class T, class U>
+inline void swap_values(std::pair<T, U>& a, std::pair<T, U>& b)
+{
+  swap_values(a.first, b.first);
+  swap_values(a.second, b.second);
+}
+//Transfers src into dst, leaving src in a valid but unspecified state.
+template <class T>
+inline void move_value(T& dst, T& src)
+{
+#ifdef HASHCOL_HAS_CXX11
+  dst = std::move(src);
+#else
+  swap_values(dst, src);
+#endif
+}
+//Copies from a constant source, moves from a modifiable one.
+template <class T>
+inline void transfer_value(T& dst, const T& src)
+{
+  dst = src;
+}
+template <class T>
+inline void transfer_value(T& dst, T& src)
+{
+  move_value(dst, src);
+}
+
+
+//Part of a slot that keeps the hash of its element, if store_hash says so
+//(hash_function.h). Without it, hashes are computed again when needed and 
+//every slot may match.
+
+template <bool stored>
+struct hash_slot__
+{
+  void set_hash(std::size_t){}
+  bool may_match(std::size_t)const{return true;}
+  bool may_equal(const hash_slot__&)const{return true;}
+  template <class hasher_t, class K>
+  std::size_t hash(const hasher_t& h, const K& k)const{return h(k);}
+  void swap_hash(hash_slot__&){}
+};
+
+template <>
+struct hash_slot__<true>
+{
+  std::size_t stored_hash_;
+  hash_slot__():stored_hash_(0){}
+  void set_hash(std::size_t h){this->stored_hash_ = h;}
+  bool may_match(std::size_t h)const{return this->stored_hash_ == h;}
+  bool may_equal(const hash_slot__& other)const{return this->stored_hash_ == other.stored_hash_;}
+  template <class hasher_t, class K>
+  std::size_t hash(const hasher_t&, const K&)const{return this->stored_hash_;}
+  void swap_hash(hash_slot__& other){std::swap(this->stored_hash_, other.stored_hash_);}
+};
+
+
+//alloc_t for elements of type T: through std::allocator_traits where there
+//is one (std::allocator has no rebind member since C++20).
+template <class alloc_t, class T>
+struct rebind_alloc__
+{
+#ifdef HASHCOL_HAS_CXX11
+  typedef typename std::allocator_traits<alloc_t>::template rebind_alloc<T> type;
+#else
+  typedef typename alloc_t::template rebind<T>::other type;
+#endif
+};
+
+
+//Slot storage. Elements are kept in a vector, together with a bitmap of the
+//slots that hold valid elements, so traversals skip empty and erased runs a
+//word at a time without touching the elements. Group probed tables also keep 
+//one control byte per slot in a parallel array.
+
+template <class element_t, class alloc_t>
+class hash_table_storage__
+{
+private:
+  typedef std::vector<element_t, alloc_t> Slots;
+  typedef typename rebind_alloc__<alloc_t, ctrl_t>::type CtrlAlloc;
+  typedef std::vector<ctrl_t, CtrlAlloc> Controls;
+  typedef typename rebind_alloc__<alloc_t, std::size_t>::type WordAlloc;
+  typedef std::vector<std::size_t, WordAlloc> Bitmap;
+
+  enum {WORD_BITS = sizeof(std::size_t) * CHAR_BIT};
+
+  Slots slots_;
+  Controls controls_;
+  Bitmap occupied_;
+
+public:
+  typedef typename Slots::value_type value_type;
+  typedef typename Slots::pointer pointer;
+  typedef typename Slots::reference reference;
+  typedef typename Slots::const_reference const_reference;
+  typedef typename Slots::size_type size_type;
+  typedef typename Slots::difference_type difference_type;
+
+  hash_table_storage__(size_type n, bool grouped):
+    slots_(n),controls_(grouped ? n : 0, ctrl_t(CTRL_EMPTY)),
+    occupied_((n + WORD_BITS - 1) / WORD_BITS, 0){}
+
+  reference operator[](size_type i){return this->slots_[i];}
+  const_reference operator[](size_type i)const{return this->slots_[i];}
+  size_type size()const{return this->slots_.size();}
+  size_type max_size()const{return this->slots_.max_size();}
+
+  ctrl_t* controls(){return &this->controls_[0];}
+  const ctrl_t* controls()const{return &this->controls_[0];}
+  //The bitmap, one bit per slot in words of WORD_BITS.
+  const std::size_t* occupied_words()const{return &this->occupied_[0];}
+  size_type num_occupied_words()const{return this->occupied_.size();}
+
+  void set_occupied(size_type i)
+  {
+    this->occupied_[i / WORD_BITS] |= std::size_t(1) << (i % WORD_BITS);
+  }
+  void clear_occupied(size_type i)
+  {
+    this->occupied_[i / WORD_BITS] &= ~(std::size_t(1) << (i % WORD_BITS));
+  }
+
+  //First occupied slot at or after i, or size() if there is none.
+  size_type next_occupied(size_type i)const
+  {
+    if (i >= this->size()) return this->size();
+    size_type w = i / WORD_BITS;
+    std::size_t word = this->occupied_[w] & (~std::size_t(0) << (i % WORD_BITS));
+    while (word == 0)
+    {
+      if (++w == this->occupied_.size()) return this->size();
+      word = this->occupied_[w];
+    }
+    return w * WORD_BITS + count_trailing_zeros(word);
+  }
+
+  //Storage can also be built a few slots at a time: reserve() allocates room
+  //for n slots and grow() constructs more of them.
+  size_type capacity()const{return this->slots_.capacity();}
+  void reserve(size_type n, bool grouped)
+  {
+    this->slots_.reserve(n);
+    if (grouped) this->controls_.reserve(n);
+    this->occupied_.reserve((n + WORD_BITS - 1) / WORD_BITS);
+  }
+  void grow(size_type n, bool grouped)
+  {
+    this->slots_.resize(n);
+    if (grouped) this->controls_.resize(n, ctrl_t(CTRL_EMPTY));
+    this->occupied_.resize((n + WORD_BITS - 1) / WORD_BITS, 0);
+  }
+
+  void swap(hash_table_storage__& other)
+  {
+    this->slots_.swap(other.slots_);
+    this->controls_.swap(other.controls_);
+    this->occupied_.swap(other.occupied_);
+  }
+};
+
+
 template <
   class hash_container_t,
   class constness_traits_t>  
@@ -85,27 +333,39 @@ struct hash_table_iterator__
   typedef typename constness_traits_t::value_type value_type;
   typedef typename constness_traits_t::pointer pointer;
   typedef typename constness_traits_t::reference reference;
+  typedef std::forward_iterator_tag iterator_category;
 
   hash_table_iterator__():
-    container_(0),current_(-1){}
+    container_(0),current_(-1),next_(0){}
   hash_table_iterator__(const hash_container_t* t, Position c):
-    container_(const_cast<hash_container_t*>(t)),current_(c){}
+    container_(const_cast<hash_container_t*>(t)),current_(c),next_(0){}
+  hash_table_iterator__(const hash_container_t* t, Position c, const hash_container_t* n):
+    container_(const_cast<hash_container_t*>(t)),current_(c),
+    next_(const_cast<hash_container_t*>(n))
+  {
+    this->go_to_next_container();
+  }
   hash_table_iterator__(const hash_table_iterator__< //A copy constructor for non-const
                                        hash_container_t,       //and conversion for const.
                                        non_const_traits<value_type> >& non_const):
-    container_(non_const.container_),current_(non_const.current_){}
+    container_(non_const.container_),current_(non_const.current_),next_(non_const.next_){}
 
   hash_container_t* container_;  
   Position current_;
+  hash_container_t* next_; //Traversal goes on here, if not null (incremental resizing).
 
   void next_not_null()
   {
-    while (true)
+    this->current_ = this->container_->next_occupied(this->current_ + 1);
+    this->go_to_next_container();
+  }
+  void go_to_next_container()
+  {
+    if (this->current_ == this->container_->size() && this->next_ != 0)
     {
-      ++this->current_;
-      if (this->current_ == this->container_->size() ||
-         (!(*this->container_)[this->current_].is_null()) &&
-         ((*this->container_)[this->current_].is_available())) break;
+      this->container_ = this->next_;
+      this->next_ = 0;
+      this->current_ = this->container_->next_occupied(0);
     }
   }
 
@@ -158,6 +418,68 @@ operator!=(const hash_table_iterator__<C, const_traits<typename C::value_type::r
 }
 
 
+//Visits the elements with a given key, following its probe sequence (through
+//both tables while resizing incrementally). Holds a copy of the key.
+template <
+  class hash_table_t,
+  class constness_traits_t>  
+struct hash_table_equal_iterator__
+{
+  typedef hash_table_equal_iterator__<hash_table_t, constness_traits_t> Self;  
+  typedef typename hash_table_t::EqualCursor Cursor;
+  typedef typename hash_table_t::key_type key_type;
+  typedef typename hash_table_t::size_type size_type;
+  typedef typename hash_table_t::difference_type difference_type;
+  typedef std::forward_iterator_tag iterator_category;
+
+  typedef typename constness_traits_t::value_type value_type;
+  typedef typename constness_traits_t::pointer pointer;
+  typedef typename constness_traits_t::reference reference;
+
+  //The end of every range. It is never advanced, so it keeps no key; only 
+  //the iterators that walk the range own a copy.
+  hash_table_equal_iterator__():
+    key_(),hash_(0){}
+  hash_table_equal_iterator__(const hash_table_t* t, const key_type& k, size_type h):
+    key_(k),hash_(h)
+  {
+    t->start_equal(this->cursor_, this->key_, this->hash_);
+  }
+  hash_table_equal_iterator__(const hash_table_equal_iterator__< //A copy constructor for non-const
+                                   hash_table_t,                  //and conversion for const.
+                                   non_const_traits<value_type> >& non_const):
+    cursor_(non_const.cursor_),key_(non_const.key_),hash_(non_const.hash_){}
+
+  Cursor cursor_;
+  key_type key_;
+  size_type hash_;
+
+  reference operator*()const
+  {
+    return const_cast<hash_table_t*>(this->cursor_.table_)->container_[this->cursor_.position_].value_;
+  }
+  pointer operator->()const {return &(operator*());}
+
+  Self& operator++()
+  {
+    this->cursor_.table_->next_equal(this->cursor_, this->key_, this->hash_);
+    return *this;    
+  }
+  Self operator++(int)
+  {
+    Self t = *this;
+    ++(*this);
+    return t;
+  }    
+
+  friend bool operator==(const Self& l, const Self& r)
+  {
+    return l.cursor_.table_ == r.cursor_.table_ && l.cursor_.position_ == r.cursor_.position_;
+  }
+  friend bool operator!=(const Self& l, const Self& r){return !(l == r);}
+};
+
+
 //Hash container.
 
 template <
@@ -167,7 +489,8 @@ template <
   class increment_t,
   class equal_key_t,
   class get_key_t,
-  class alloc_t> 
+  class alloc_t,
+  class growth_t> 
 class hash_table__
 {
 private:
@@ -178,9 +501,10 @@ private:
     increment_t,
     equal_key_t, 
     get_key_t,
-    alloc_t> Self;  
+    alloc_t,
+    growth_t> Self;  
 
-  struct Element
+  struct Element : hash_slot__<store_hash<key_t>::value>
   {
     enum {EMPTY = 0, FULL = 1, NOT_AVAILABLE = 2};
     typedef value_t real_value_type;
@@ -189,14 +513,14 @@ private:
     bool is_null()const{return this->state_ == EMPTY;}
     bool is_available()const{return this->state_ != NOT_AVAILABLE;}
     void make_unavailable(){this->state_ = NOT_AVAILABLE;}
-    Element():state_(EMPTY){}
-    Element(const value_t& v):value_(v),state_(FULL){}
+    //Robin Hood tables keep the probe distance of full slots above the FULL bit.
+    std::size_t probe_distance()const{return this->state_ >> 1;}
+    void set_probe_distance(std::size_t d){this->state_ = FULL | int(d << 1);}
+    Element():value_(),state_(EMPTY){}
   };
-  typedef typename alloc_t::template rebind<Element>::other ActualAlloc;
-  typedef std::vector<Element, ActualAlloc> Container;
-
-  struct Unique{};
-  struct Multi{};
+  typedef typename rebind_alloc__<alloc_t, Element>::type ActualAlloc;
+  typedef hash_table_storage__<Element, ActualAlloc> Container;
+  typedef typename probing_traits<increment_t>::category Probing;
 
 public:
   typedef key_t key_type;
@@ -206,6 +530,7 @@ public:
   typedef equal_key_t key_equal;
   typedef get_key_t get_key;
   typedef alloc_t allocator;
+  typedef growth_t growth_policy;
 
   typedef typename Container::pointer pointer;
   typedef typename Container::reference reference;
@@ -216,6 +541,10 @@ public:
   //Iterator types.
   typedef hash_table_iterator__<Container, non_const_traits<value_type> > iterator;
   typedef hash_table_iterator__<Container, const_traits<value_type> > const_iterator;
+  typedef hash_table_equal_iterator__<Self, non_const_traits<value_type> > equal_iterator;
+  typedef hash_table_equal_iterator__<Self, const_traits<value_type> > const_equal_iterator;
+  template <class T, class C> friend struct hash_table_equal_iterator__;
+  template <class T> friend class mapped_hash_table__;
   
 
 private:
@@ -223,7 +552,12 @@ private:
   size_type TABLE_SIZE_;
   size_type NUM_ELEMENTS_;
   size_type NUM_VALID_ELEMENTS_;
+  float MAX_LOAD_FACTOR_;
+  size_type MAX_ELEMENTS_; //Grows beyond this.
   Container container_;
+  Self* old_; //Elements not moved yet since the last growth, if resizing incrementally.
+  size_type MIGRATION_POSITION_; //Where moving from old_ is resumed.
+  Container spare_; //Slots for the next growth, constructed ahead of it.
 
   //Interface.
   hasher hash_;
@@ -231,251 +565,1919 @@ private:
   key_equal key_equals_;
   get_key get_key_;
 
-  template <class MultiOrUnique>
-  void expand(MultiOrUnique);  
-  
-  size_type find_position(const key_type& k)
+  void resize_table(size_type table_size);  
+  void expand()
   {
-    size_type hx = this->hash_(k) % this->TABLE_SIZE_;
-    Element* current = &this->container_[hx];
-    while (!current->is_null())
+    size_type t = table_size(growth_t::next_size(this->TABLE_SIZE_), Probing());
+    if (growth_t::migration_step() == 0 || this->old_ != 0) this->resize_table(t);
+    else this->start_migration(t);
+  }
+
+  //Incremental resizing. The current elements are handed to a table of their
+  //own, which is drained into this one by migrate(). Constructing the new 
+  //slots would cost about as much as moving the elements, so that is spread 
+  //too: once the table is half way to its limit, every insertion builds its
+  //share of them in spare_.
+  bool preparing_growth()const
+  {
+    return growth_t::migration_step() != 0 && this->old_ == 0 && 
+           this->NUM_ELEMENTS_ > this->MAX_ELEMENTS_ / 2;
+  }
+  void prepare_growth()
+  {
+    size_type t = table_size(growth_t::next_size(this->TABLE_SIZE_), Probing());
+    if (this->spare_.capacity() < t || this->spare_.size() > t)
+    {
+      Container(0, grouped(Probing())).swap(this->spare_);
+      this->spare_.reserve(t, grouped(Probing()));
+    }
+    size_type left = this->MAX_ELEMENTS_ - this->NUM_ELEMENTS_ + 1; //Insertions.
+    size_type n = this->spare_.size() + (t - this->spare_.size() + left - 1) / left;
+    this->spare_.grow(std::min(n, t), grouped(Probing()));
+  }
+  void start_migration(size_type table_size)
+  {
+    Container slots(0, grouped(Probing()));
+    slots.swap(this->spare_);
+    if (slots.size() > table_size) Container(0, grouped(Probing())).swap(slots);
+    slots.grow(table_size, grouped(Probing()));
+    Self* old = new Self(0, this->hash_, this->key_equals_);
+    old->swap(*this);
+    this->MAX_LOAD_FACTOR_ = old->MAX_LOAD_FACTOR_;
+    this->reinit(table_size, slots);
+    this->old_ = old;
+    this->MIGRATION_POSITION_ = 0;
+  }
+  void migrate()
+  {
+    for (size_type n = growth_t::migration_step(); this->old_ != 0 && n != 0; --n)
     {
-      if (current->is_available() &&
-          this->key_equals_(k, this->get_key_(current->value_)))
+      if (this->old_->NUM_VALID_ELEMENTS_ == 0)
       {
-        return hx;
+        delete this->old_;
+        this->old_ = 0;
       }
-      hx = hx + this->increment_(k);
-      current = &this->container_[hx];
+      else if (this->NUM_ELEMENTS_ <= this->MAX_ELEMENTS_)
+      {
+        //Erasures in old_ may put elements behind the position, hence the wrap.
+        Container& old = this->old_->container_;
+        size_type i = old.next_occupied(this->MIGRATION_POSITION_);
+        if (i == old.size()) i = old.next_occupied(0);
+        this->insert_absent(old[i]);
+        this->old_->erase_position(i, Probing());
+        this->MIGRATION_POSITION_ = i;
+      }
+      else return; //make_room() will take the rest.
     }
-    return this->container_.size();
   }
-
-  void reinit(size_type table_size)
+  iterator old_iterator(size_type i)
   {
-    this->NUM_ELEMENTS_ = 0;
-    this->NUM_VALID_ELEMENTS_ = 0;
-    this->TABLE_SIZE_ = table_size;
-    this->container_ = Container(table_size);
+    return iterator(&this->old_->container_, i, &this->container_);
+  }
+  const_iterator old_iterator(size_type i)const
+  {
+    return const_iterator(&this->old_->container_, i, &this->container_);
   }
 
-  void insert_by_type(const Element& element, Unique)
+  //Capacity needed for n elements under load factor z.
+  static size_type capacity_for(size_type n, float z)
   {
-    this->insert_unique(element.value_);
+    return table_size(size_type(std::ceil(n / double(z))), Probing());
   }
-  void insert_by_type(const Element& element, Multi)
+  //At least one slot must stay empty, even after the insertion that finds 
+  //the table at its limit.
+  size_type load_limit(size_type table_size)const
   {
-    this->insert_equal(element.value_);
+    size_type limit = size_type(table_size * double(this->MAX_LOAD_FACTOR_));
+    return std::min(limit, table_size - 2);
   }
-  
-public:
-  hash_table__(size_type max):
-    TABLE_SIZE_(2*max),NUM_ELEMENTS_(0),NUM_VALID_ELEMENTS_(0),container_(2*max){}
-  hash_table__(size_type max, const hasher& h):
-    TABLE_SIZE_(2*max),NUM_ELEMENTS_(0),NUM_VALID_ELEMENTS_(0),container_(2*max),hash_(h){}
-  hash_table__(size_type max, const hasher& h, const key_equal& eq):
-    TABLE_SIZE_(2*max),NUM_ELEMENTS_(0),NUM_VALID_ELEMENTS_(0),container_(2*max),hash_(h),key_equals_(eq){}
 
+  static bool grouped(open_probing_tag){return false;}
+  static bool grouped(robin_hood_probing_tag){return false;}
+  static bool grouped(group_probing_tag){return true;}
+  static unsigned probing_id(open_probing_tag){return 0;}
+  static unsigned probing_id(group_probing_tag){return 1;}
+  static unsigned probing_id(robin_hood_probing_tag){return 2;}
 
-  //Getters.
-  hasher hash_funct()const{return this->hash_;}
-  key_equal key_eq()const{return this->key_equals_;}
-  
-  void swap(Self& other)
+  static size_type table_size(size_type n, open_probing_tag){return growth_t::table_size(n);}
+  static size_type table_size(size_type n, robin_hood_probing_tag){return growth_t::table_size(n);}
+  static size_type table_size(size_type n, group_probing_tag)
   {
-    std::swap(this->TABLE_SIZE_, other.TABLE_SIZE_);
-    std::swap(this->NUM_ELEMENTS_, other.NUM_ELEMENTS_);
-    std::swap(this->NUM_VALID_ELEMENTS_, other.NUM_VALID_ELEMENTS_);
-    this->container_.swap(other.container_); //Constant for vector.
-    std::swap(this->hash_, other.hash_);
-    std::swap(this->increment_, other.increment_);
-    std::swap(this->key_equals_, other.key_equals_);
-    std::swap(this->get_key_, other.get_key_);
+    return std::max<size_type>(next_power_of_two(n), control_group::WIDTH);
   }
   
-  std::pair<iterator, bool> insert_unique(const value_type& x)
+  //Hash of the element in e, stored or computed.
+  size_type hash_of(const Element& e)const
   {
-    if (this->NUM_ELEMENTS_ > this->TABLE_SIZE_/2) this->expand(Unique());
-    key_type xkey = this->get_key_(x);
-    size_type hx = this->hash_(xkey) % this->TABLE_SIZE_;
-    while (!this->container_[hx].is_null())
+    return e.hash(this->hash_, this->get_key_(e.value_));
+  }
+  //Whether e, full, holds key k, whose hash is h.
+  template <class K>
+  bool holds(const Element& e, const K& k, size_type h)const
+  {
+    return e.may_match(h) && this->key_equals_(k, this->get_key_(e.value_));
+  }
+
+  template <class K>
+  size_type find_position(const K& k)const
+  {
+    return this->find_position(k, this->hash_(k), Probing());
+  }
+  template <class K>
+  size_type find_position(const K& k, size_type h, open_probing_tag)const
+  {
+    size_type hx = growth_t::position(h, this->TABLE_SIZE_);
+    size_type step = this->increment_(k);
+    const Element* current = &this->container_[hx];
+    while (!current->is_null())
     {
-      if (this->container_[hx].is_available() &&
-          this->key_equals_(xkey, this->get_key_(this->container_[hx].value_)))
+      if (current->is_available() && this->holds(*current, k, h))
       {
-        return std::make_pair(iterator(&this->container_, hx), false);
+        return hx;
       }
-      hx = (hx + this->increment_(xkey)) % this->TABLE_SIZE_; 
+      hx = growth_t::next_position(hx, step, this->TABLE_SIZE_);
+      current = &this->container_[hx];
     }
-    this->container_[hx] = x;
-    ++this->NUM_ELEMENTS_;
-    ++this->NUM_VALID_ELEMENTS_;
-    return std::make_pair(iterator(&this->container_, hx), true);
+    return this->container_.size();
   }
-  iterator insert_equal(const value_type& x)
+  template <class K>
+  size_type find_position(const K& k, size_type h, robin_hood_probing_tag)const
   {
-    if (this->NUM_ELEMENTS_ > this->TABLE_SIZE_/2) this->expand(Multi());
-    key_type xkey = this->get_key_(x);
-    size_type hx = this->hash_(xkey) % this->TABLE_SIZE_;
-    while (!this->container_[hx].is_null())
+    size_type hx = growth_t::position(h, this->TABLE_SIZE_);
+    for (size_type d = 0; ; ++d)
     {
-      hx = (hx + this->increment_(xkey)) % this->TABLE_SIZE_; 
+      const Element& current = this->container_[hx];
+      if (current.is_null() || current.probe_distance() < d) break;
+      if (this->holds(current, k, h)) return hx;
+      hx = growth_t::next_position(hx, 1, this->TABLE_SIZE_);
     }
-    this->container_[hx] = x;
-    ++this->NUM_ELEMENTS_;
-    ++this->NUM_VALID_ELEMENTS_;
-    return iterator(&this->container_, hx);
-  }
-  template <class input_iterator_t>
-  void insert_unique(input_iterator_t b, input_iterator_t e)
-  {
-    for (; b != e; ++b) insert_unique(*b);
+    return this->container_.size();
   }
-  template <class input_iterator_t>
-  void insert_equal(input_iterator_t b, input_iterator_t e)
+  template <class K>
+  size_type find_position(const K& k, size_type h, group_probing_tag)const
   {
-    for (; b != e; ++b) insert_equal(*b);
+    size_type h1;
+    ctrl_t h2;
+    this->split_hash(h, h1, h2);
+    const ctrl_t* ctrl = this->container_.controls();
+    for (group_probe_sequence seq(h1, this->num_groups()); ; seq.next())
+    {
+      control_group group(ctrl + seq.offset());
+      for (unsigned m = group.match(h2); m != 0; m &= m - 1)
+      {
+        size_type i = seq.offset() + count_trailing_zeros(m);
+        if (this->holds(this->container_[i], k, h)) return i;
+      }
+      if (group.match_empty() != 0) return this->container_.size();
+    }
   }
 
-  void erase(iterator it)
-  { 
-    this->container_[it.current_].make_unavailable(); 
-    --this->NUM_VALID_ELEMENTS_; 
+  //Diagnostics. Slots (groups) visited when looking k up, as find_position()
+  //does, the last one included.
+  template <class K>
+  size_type probe_length(const K& k, open_probing_tag)const
+  {
+    size_type h = this->hash_(k);
+    size_type hx = growth_t::position(h, this->TABLE_SIZE_);
+    size_type step = this->increment_(k);
+    size_type n = 1;
+    for (; !this->container_[hx].is_null(); ++n)
+    {
+      if (this->container_[hx].is_available() && this->holds(this->container_[hx], k, h))
+      {
+        break;
+      }
+      hx = growth_t::next_position(hx, step, this->TABLE_SIZE_);
+    }
+    return n;
   }
-  void erase(iterator b, iterator e)
+  template <class K>
+  size_type probe_length(const K& k, robin_hood_probing_tag)const
   {
-    for (; b != e; ++b) this->erase(b);
+    size_type h = this->hash_(k);
+    size_type hx = growth_t::position(h, this->TABLE_SIZE_);
+    for (size_type d = 0; ; ++d)
+    {
+      const Element& current = this->container_[hx];
+      if (current.is_null() || current.probe_distance() < d || this->holds(current, k, h))
+      {
+        return d + 1;
+      }
+      hx = growth_t::next_position(hx, 1, this->TABLE_SIZE_);
+    }
   }
-  size_type erase(const key_type& k) //Could implement "erase_unique"
-    //with a break inside the loop for better performance in unique containers.
+  template <class K>
+  size_type probe_length(const K& k, group_probing_tag)const
   {
-    size_type erased = 0;
-    size_type hx = this->hash_(k) % this->TABLE_SIZE_;
-    Element * current = &this->container_[hx];
-    while (!current->is_null())
+    size_type h = this->hash_(k);
+    size_type h1;
+    ctrl_t h2;
+    this->split_hash(h, h1, h2);
+    const ctrl_t* ctrl = this->container_.controls();
+    size_type n = 1;
+    for (group_probe_sequence seq(h1, this->num_groups()); ; seq.next(), ++n)
     {
-      if (current->is_available() &&
-          this->key_equals_(k, this->get_key_(current->value_)))
+      control_group group(ctrl + seq.offset());
+      for (unsigned m = group.match(h2); m != 0; m &= m - 1)
       {
-        current->make_unavailable();
-        --this->NUM_VALID_ELEMENTS_;
-        ++erased;
+        size_type i = seq.offset() + count_trailing_zeros(m);
+        if (this->holds(this->container_[i], k, h)) return n;
       }
-      hx = (hx + this->increment_(k)) % this->TABLE_SIZE_;
-      current = &this->container_[hx];
+      if (group.match_empty() != 0) return n;
     }
-    return erased;
   }
-
-  iterator find(const key_type& k)
+  template <class K>
+  size_type home_bucket(const K& k, open_probing_tag)const
   {
-    return iterator(&this->container_, this->find_position(k));
+    return growth_t::position(this->hash_(k), this->TABLE_SIZE_);
   }
-  const_iterator find(const key_type& k)const
+  template <class K>
+  size_type home_bucket(const K& k, robin_hood_probing_tag)const
   {
-    return const_iterator(&this->container_, this->find_position(k));
+    return growth_t::position(this->hash_(k), this->TABLE_SIZE_);
   }
-
-  size_type size()const{return this->NUM_VALID_ELEMENTS_;}
-  size_type max_size()const{return this->container_.max_size();}
-  size_type bucket_count()const{return this->TABLE_SIZE_;}
-  bool empty()const{return 0 == this->NUM_VALID_ELEMENTS_;}
-  void resize_unique(size_type n){while (n > this->TABLE_SIZE_) this->expand(Unique());}
-  void resize_equal(size_type n){while (n > this->TABLE_SIZE_) this->expand(Multi());}
-  void clear(){this->reinit(this->TABLE_SIZE_);}
-
-  size_type count(const key_type& k)const
-  { 
-    size_type num = 0;
-    for (const_iterator it = begin(); it != end(); ++it)
-      if (this->key_equals_(this->get_key_(*it), k)) ++num;
-    return num;
+  template <class K>
+  size_type home_bucket(const K& k, group_probing_tag)const
+  {
+    size_type h1;
+    ctrl_t h2;
+    this->split_hash(this->hash_(k), h1, h2);
+    return h1;
   }
+  size_type num_buckets(open_probing_tag)const{return this->TABLE_SIZE_;}
+  size_type num_buckets(robin_hood_probing_tag)const{return this->TABLE_SIZE_;}
+  size_type num_buckets(group_probing_tag)const{return this->num_groups();}
 
-  iterator begin()
+  //Group probing helpers.
+  size_type num_groups()const{return this->TABLE_SIZE_ / control_group::WIDTH;}
+  void split_hash(size_type h, size_type& h1, ctrl_t& h2)const
   {
-    for (size_type i = 0; i < this->container_.size(); ++i)
-      if (!this->container_[i].is_null() && this->container_[i].is_available())
-        return iterator(&this->container_, i);
-    return end();
+    split_group_hash(h, count_trailing_zeros(this->num_groups()), h1, h2);
   }
-  iterator end()
+  size_type find_free_position(size_type h1)const
   {
-    return iterator(&this->container_, this->container_.size());
+    const ctrl_t* ctrl = this->container_.controls();
+    for (group_probe_sequence seq(h1, this->num_groups()); ; seq.next())
+    {
+      unsigned m = control_group(ctrl + seq.offset()).match_empty_or_deleted();
+      if (m != 0) return seq.offset() + count_trailing_zeros(m);
+    }
   }
-  const_iterator begin()const
+  template <class source_t>
+  void fill_position(size_type hx, source_t& x, size_type h, ctrl_t h2)
   {
-    for (size_type i = 0; i < this->container_.size(); ++i)
-      if (!this->container_[i].is_null() && this->container_[i].is_available())
-        return const_iterator(&this->container_, i);
-    return end();
+    ctrl_t& c = this->container_.controls()[hx];
+    if (c == CTRL_EMPTY) ++this->NUM_ELEMENTS_; //Otherwise reuses a deleted slot.
+    c = h2;
+    this->fill_slot(hx, x, h);
+    ++this->NUM_VALID_ELEMENTS_;
   }
-  const_iterator end()const
+
+  void erase_position(size_type hx, open_probing_tag)
   {
-    return const_iterator(&this->container_, this->container_.size());
+    this->container_[hx].make_unavailable();
+    this->container_.clear_occupied(hx);
+    --this->NUM_VALID_ELEMENTS_;
+  }
+  void erase_position(size_type hx, robin_hood_probing_tag)
+  {
+    //Backward shift: pull the rest of the cluster one slot closer to home.
+    size_type next = growth_t::next_position(hx, 1, this->TABLE_SIZE_);
+    while (!this->container_[next].is_null() && 
+           this->container_[next].probe_distance() > 0)
+    {
+      swap_values(this->container_[hx].value_, this->container_[next].value_);
+      this->container_[hx].swap_hash(this->container_[next]);
+      this->container_[hx].set_probe_distance(this->container_[next].probe_distance() - 1);
+      hx = next;
+      next = growth_t::next_position(hx, 1, this->TABLE_SIZE_);
+    }
+    this->container_[hx] = Element();
+    this->container_.clear_occupied(hx);
+    --this->NUM_ELEMENTS_;
+    --this->NUM_VALID_ELEMENTS_;
+  }
+  void erase_position(size_type hx, group_probing_tag)
+  {
+    this->container_.clear_occupied(hx);
+    ctrl_t* ctrl = this->container_.controls();
+    size_type offset = hx - hx % control_group::WIDTH;
+    if (control_group(ctrl + offset).match_empty() != 0)
+    {
+      ctrl[hx] = CTRL_EMPTY;
+      this->container_[hx] = Element();
+      --this->NUM_ELEMENTS_;
+    }
+    else
+    {
+      ctrl[hx] = CTRL_DELETED;
+      this->container_[hx].make_unavailable();
+    }
+    --this->NUM_VALID_ELEMENTS_;
   }
 
-  template <class K, class V, class H, class I, class E, class G, class A>
-  friend bool 
-  operator==(const hash_table__<K, V, H, I, E, G, A>& l, 
-             const hash_table__<K, V, H, I, E, G, A>& r);
-
-};
-
-template <
-  class key_t, 
-  class value_t, 
-  class hash_fcn_t,
-  class increment_t,
-  class equal_key_t,
-  class get_key_t,
-  class alloc_t> 
-  template <class MultiOrUnique>
-void
-hash_table__<
-  key_t,
-  value_t,
-  hash_fcn_t,
-  increment_t,
-  equal_key_t,
-  get_key_t,
-  alloc_t>::
-expand(MultiOrUnique type)
-{
-  #ifdef DEBUG
-    std::cout << "\nEXPANDINDO TABELA DE HASH...";
-  #endif 
-
-  Container copy(this->container_);
-  this->reinit(2 * this->TABLE_SIZE_);  
-  for (typename Container::iterator it = copy.begin(); it != copy.end(); ++it)
-    if (!(it->is_null()) && it->is_available())  insert_by_type(*it, type);
-}
-
-//If this is not the semantics you expect, feel free to re-write it.
-template <class K, class V, class H, class I, class E, class G, class A>
-inline bool 
-operator==(const hash_table__<K, V, H, I, E, G, A>& l, 
-           const hash_table__<K, V, H, I, E, G, A>& r)
-{
-  typedef typename hash_table__<K, V, H, I, E, G, A>::size_type size_type;
-
-  if (l.TABLE_SIZE_ == r.TABLE_SIZE_ &&
-      l.NUM_ELEMENTS_ == r.NUM_ELEMENTS_ &&
-      l.NUM_VALID_ELEMENTS_ == r.NUM_VALID_ELEMENTS_ &&
-      l.container_.size() == r.container_.size())
-  {
-    for (size_type i = 0; i < l.container_.size(); ++i)
-      if (!((l.container_[i].is_available() && r.container_[i].is_available() &&
-             l.container_[i].value_ == r.container_[i].value_) 
-             ||
-            (!l.container_[i].is_available() && r.container_[i].is_available())))
+  //Insertion is split in two: find_slot() looks the key up and, if it is
+  //absent, finds where it goes (Slot); place() then puts an element there.
+  //Nothing else may change the table in between. With unique keys the 
+  //element only has to be made once the key is known to be absent.
+  struct Slot
+  {
+    size_type hash_;
+    size_type position_;
+    size_type distance_; //Robin Hood.
+    ctrl_t h2_; //Group probing.
+    bool found_;
+  };
+  template <class K>
+  Slot find_slot(const K& k, size_type h, open_probing_tag)const
+  {
+    Slot s;
+    s.hash_ = h;
+    s.found_ = false;
+    size_type hx = growth_t::position(h, this->TABLE_SIZE_);
+    size_type step = this->increment_(k);
+    while (!this->container_[hx].is_null())
+    {
+      if (this->container_[hx].is_available() && this->holds(this->container_[hx], k, h))
       {
-        return false;
+        s.found_ = true;
+        break;
       }
-    return true;
+      hx = growth_t::next_position(hx, step, this->TABLE_SIZE_);
+    }
+    s.position_ = hx;
+    return s;
   }
-  return false;  
+  template <class K>
+  Slot find_slot(const K& k, size_type h, group_probing_tag)const
+  {
+    Slot s;
+    s.hash_ = h;
+    s.position_ = this->find_position(k, h, group_probing_tag());
+    s.found_ = s.position_ != this->container_.size();
+    if (!s.found_)
+    {
+      size_type h1;
+      this->split_hash(h, h1, s.h2_);
+      s.position_ = this->find_free_position(h1);
+    }
+    return s;
+  }
+  template <class K>
+  Slot find_slot(const K& k, size_type h, robin_hood_probing_tag)const
+  {
+    Slot s;
+    s.hash_ = h;
+    s.found_ = false;
+    size_type hx = growth_t::position(h, this->TABLE_SIZE_);
+    size_type d = 0;
+    for (; ; ++d)
+    {
+      const Element& current = this->container_[hx];
+      if (current.is_null() || current.probe_distance() < d) break;
+      if (this->holds(current, k, h))
+      {
+        s.found_ = true;
+        break;
+      }
+      hx = growth_t::next_position(hx, 1, this->TABLE_SIZE_);
+    }
+    s.position_ = hx;
+    s.distance_ = d;
+    return s;
+  }
+  //Where an element with key k goes regardless of the elements already there.
+  template <class K>
+  Slot find_free_slot(const K& k, size_type h, open_probing_tag)const
+  {
+    Slot s;
+    s.hash_ = h;
+    s.found_ = false;
+    size_type hx = growth_t::position(h, this->TABLE_SIZE_);
+    size_type step = this->increment_(k);
+    while (!this->container_[hx].is_null())
+      hx = growth_t::next_position(hx, step, this->TABLE_SIZE_);
+    s.position_ = hx;
+    return s;
+  }
+  template <class K>
+  Slot find_free_slot(const K&, size_type h, group_probing_tag)const
+  {
+    Slot s;
+    s.hash_ = h;
+    s.found_ = false;
+    size_type h1;
+    this->split_hash(h, h1, s.h2_);
+    s.position_ = this->find_free_position(h1);
+    return s;
+  }
+  template <class K>
+  Slot find_free_slot(const K&, size_type h, robin_hood_probing_tag)const
+  {
+    Slot s;
+    s.hash_ = h;
+    s.found_ = false;
+    size_type hx = growth_t::position(h, this->TABLE_SIZE_);
+    size_type d = 0;
+    for (; !this->container_[hx].is_null() && this->container_[hx].probe_distance() >= d; ++d)
+      hx = growth_t::next_position(hx, 1, this->TABLE_SIZE_);
+    s.position_ = hx;
+    s.distance_ = d;
+    return s;
+  }
+
+  //Copies x, or moves it if it is not const.
+  template <class source_t>
+  void place(const Slot& s, source_t& x, open_probing_tag)
+  {
+    this->fill_slot(s.position_, x, s.hash_);
+    ++this->NUM_ELEMENTS_;
+    ++this->NUM_VALID_ELEMENTS_;
+  }
+  template <class source_t>
+  void place(const Slot& s, source_t& x, group_probing_tag)
+  {
+    this->fill_position(s.position_, x, s.hash_, s.h2_);
+  }
+  template <class source_t>
+  void place(const Slot& s, source_t& x, robin_hood_probing_tag)
+  {
+    Element carry;
+    transfer_value(carry.value_, x);
+    carry.set_hash(s.hash_);
+    this->displace(s.position_, carry, s.distance_);
+  }
+  //Puts carry at hx, d slots away from its home. Whatever was there moves on, 
+  //taking the place of the first element closer to its home than itself,
+  //and so on until an empty slot is reached. Elements are swapped along the
+  //way, so carry is left with an unspecified value.
+  void displace(size_type hx, Element& carry, size_type d)
+  {
+    this->shift_in(hx, carry, d);
+    ++this->NUM_ELEMENTS_;
+    ++this->NUM_VALID_ELEMENTS_;
+  }
+  void shift_in(size_type hx, Element& carry, size_type d)
+  {
+    carry.set_probe_distance(d);
+    while (!this->container_[hx].is_null())
+    {
+      Element& current = this->container_[hx];
+      if (current.probe_distance() < carry.probe_distance())
+        this->swap_elements(current, carry);
+      hx = growth_t::next_position(hx, 1, this->TABLE_SIZE_);
+      carry.set_probe_distance(carry.probe_distance() + 1);
+    }
+    this->swap_elements(this->container_[hx], carry);
+    this->container_.set_occupied(hx);
+  }
+  //Puts x in the empty slot hx. Counting it is up to the caller.
+  template <class source_t>
+  void fill_slot(size_type hx, source_t& x, size_type h)
+  {
+    Element& slot = this->container_[hx];
+    transfer_value(slot.value_, x);
+    slot.set_hash(h);
+    slot.state_ = Element::FULL;
+    this->container_.set_occupied(hx);
+  }
+
+  //Rehash helper. The key is known to be absent and the table to have room,
+  //so the element goes to the first free slot of its probe sequence without 
+  //comparing keys. The value is moved from e.
+  void insert_absent(Element& e)
+  {
+    Slot s = this->find_free_slot(this->get_key_(e.value_), this->hash_of(e), Probing());
+    this->place(s, e.value_, Probing());
+  }
+
+  //Housekeeping before an insertion: makes room, prepares or carries on an 
+  //incremental resize. Returns whether elements may have moved.
+  bool make_room_for_one()
+  {
+    bool moved = false;
+    if (this->NUM_ELEMENTS_ > this->MAX_ELEMENTS_) 
+    {
+      this->make_room();
+      moved = true;
+    }
+    else if (this->preparing_growth()) this->prepare_growth();
+    if (this->old_ != 0) 
+    {
+      this->migrate();
+      moved = true;
+      if (this->NUM_ELEMENTS_ > this->MAX_ELEMENTS_) this->make_room();
+    }
+    return moved;
+  }
+  //Finds k, whose hash is h, or else gets s ready for inserting it. Elements
+  //are only moved around once k is known to be absent, so k may refer to an
+  //element.
+  template <class K>
+  std::pair<iterator, bool> prepare_unique(const K& k, size_type h, Slot& s)
+  {
+    if (this->old_ != 0)
+    {
+      size_type i = this->old_->find_position(k, h, Probing());
+      if (i != this->old_->container_.size()) return std::make_pair(this->old_iterator(i), false);
+    }
+    s = this->find_slot(k, h, Probing());
+    if (s.found_) return std::make_pair(iterator(&this->container_, s.position_), false);
+    if (this->make_room_for_one()) s = this->find_free_slot(k, h, Probing());
+    return std::make_pair(this->end(), true);
+  }
+  template <class source_t>
+  std::pair<iterator, bool> insert_unique_value(source_t& x, size_type h)
+  {
+    Slot s;
+    std::pair<iterator, bool> r = this->prepare_unique(this->get_key_(x), h, s);
+    if (!r.second) return r;
+    this->place(s, x, Probing());
+    return std::make_pair(iterator(&this->container_, s.position_), true);
+  }
+  template <class source_t>
+  iterator insert_equal_value(source_t& x, size_type h)
+  {
+    this->make_room_for_one();
+    Slot s = this->find_free_slot(this->get_key_(x), h, Probing());
+    this->place(s, x, Probing());
+    return iterator(&this->container_, s.position_);
+  }
+
+  //Range insertion. Forward ranges are counted first, so that the table 
+  //grows at most once, and then taken a block at a time: all keys of a block
+  //are hashed, the slots where their probes start are prefetched, and only
+  //then are they placed. Input ranges can only be read once; their blocks 
+  //are copied, and only if the hasher is faster on many keys (hash_batch()).
+  enum {HASH_BLOCK = 64};
+  template <class input_iterator_t>
+  void insert_range(input_iterator_t b, input_iterator_t e, bool unique, std::input_iterator_tag)
+  {
+    this->insert_range(b, e, unique, typename hashing_traits<hasher>::category());
+  }
+  template <class forward_iterator_t>
+  void insert_range(forward_iterator_t b, forward_iterator_t e, bool unique, std::forward_iterator_tag)
+  {
+    if (b == e) return;
+    this->reserve(this->size() + std::distance(b, e));
+    std::size_t hashes[LOOKUP_BLOCK];
+    while (b != e)
+    {
+      forward_iterator_t block = b;
+      size_type n = 0;
+      for (; b != e && n != LOOKUP_BLOCK; ++b) ++n;
+      this->hash_values(block, n, hashes, typename hashing_traits<hasher>::category());
+      if (this->TABLE_SIZE_ * sizeof(Element) >= PREFETCH_TABLE_BYTES)
+        for (size_type i = 0; i != n; ++i) this->prefetch_home(hashes[i], Probing());
+      for (size_type i = 0; i != n; ++i, ++block) this->insert_hashed(*block, hashes[i], unique);
+    }
+  }
+  template <class forward_iterator_t>
+  void hash_values(forward_iterator_t b, size_type n, std::size_t* hashes, scalar_hashing_tag)const
+  {
+    for (size_type i = 0; i != n; ++i, ++b) hashes[i] = this->hash_(this->get_key_(*b));
+  }
+  template <class forward_iterator_t>
+  void hash_values(forward_iterator_t b, size_type n, std::size_t* hashes, batch_hashing_tag)const
+  {
+    key_type keys[LOOKUP_BLOCK] = {};
+    for (size_type i = 0; i != n; ++i, ++b) keys[i] = this->get_key_(*b);
+    hash_batch(this->hash_, keys, n, hashes);
+  }
+  void insert_hashed(const value_type& x, size_type h, bool unique)
+  {
+    if (unique) this->insert_unique_value(x, h);
+    else this->insert_equal_value(x, h);
+  }
+#ifdef HASHCOL_HAS_CXX11
+  void insert_hashed(value_type&& x, size_type h, bool unique)
+  {
+    if (unique) this->insert_unique_value(x, h);
+    else this->insert_equal_value(x, h);
+  }
+#endif
+  template <class input_iterator_t>
+  void insert_range(input_iterator_t b, input_iterator_t e, bool unique, scalar_hashing_tag)
+  {
+    for (; b != e; ++b)
+    {
+      if (unique) this->insert_unique(*b);
+      else this->insert_equal(*b);
+    }
+  }
+  template <class input_iterator_t>
+  void insert_range(input_iterator_t b, input_iterator_t e, bool unique, batch_hashing_tag)
+  {
+    std::vector<value_type> block;
+    block.reserve(HASH_BLOCK);
+    key_type keys[HASH_BLOCK];
+    std::size_t hashes[HASH_BLOCK];
+    while (b != e)
+    {
+      block.clear();
+      for (; b != e && block.size() != HASH_BLOCK; ++b) block.push_back(*b);
+      for (size_type i = 0; i != block.size(); ++i) keys[i] = this->get_key_(block[i]);
+      hash_batch(this->hash_, keys, block.size(), hashes);
+      for (size_type i = 0; i != block.size(); ++i)
+      {
+        if (unique) this->insert_unique_value(block[i], hashes[i]);
+        else this->insert_equal_value(block[i], hashes[i]);
+      }
+    }
+  }
+
+  //Batched lookups. Every key of a block is hashed and the memory its probe
+  //starts at is prefetched before any of them is looked up, so the cache 
+  //misses of a block overlap instead of coming one after the other. Tables
+  //small enough to stay in cache are not worth the extra passes.
+  enum {LOOKUP_BLOCK = 16, PREFETCH_TABLE_BYTES = 1 << 22};
+  template <class forward_iterator_t>
+  void hash_block(forward_iterator_t b, size_type n, std::size_t* hashes, scalar_hashing_tag)const
+  {
+    for (size_type i = 0; i != n; ++i, ++b) hashes[i] = this->hash_(*b);
+  }
+  template <class forward_iterator_t>
+  void hash_block(forward_iterator_t b, size_type n, std::size_t* hashes, batch_hashing_tag)const
+  {
+    key_type keys[LOOKUP_BLOCK] = {};
+    for (size_type i = 0; i != n; ++i, ++b) keys[i] = *b;
+    hash_batch(this->hash_, keys, n, hashes);
+  }
+  void prefetch_home(size_type h, open_probing_tag)const
+  {
+    prefetch(&this->container_[growth_t::position(h, this->TABLE_SIZE_)]);
+  }
+  void prefetch_home(size_type h, robin_hood_probing_tag)const
+  {
+    prefetch(&this->container_[growth_t::position(h, this->TABLE_SIZE_)]);
+  }
+  void prefetch_home(size_type h, group_probing_tag)const
+  {
+    size_type h1;
+    ctrl_t h2;
+    this->split_hash(h, h1, h2);
+    prefetch(this->container_.controls() + h1 * control_group::WIDTH);
+  }
+  //Group probing needs a second round: the slot that matches is known only
+  //once the control bytes are in.
+  void prefetch_match(size_type, open_probing_tag)const{}
+  void prefetch_match(size_type, robin_hood_probing_tag)const{}
+  void prefetch_match(size_type h, group_probing_tag)const
+  {
+    size_type h1;
+    ctrl_t h2;
+    this->split_hash(h, h1, h2);
+    size_type offset = h1 * control_group::WIDTH;
+    unsigned m = control_group(this->container_.controls() + offset).match(h2);
+    if (m != 0) prefetch(&this->container_[offset + count_trailing_zeros(m)]);
+  }
+  //Looks up the n keys from b. The i-th is at positions[i], of old_ if 
+  //in_old[i], or is absent if positions[i] is container_.size().
+  template <class forward_iterator_t>
+  void find_block(forward_iterator_t b, size_type n, size_type* positions, bool* in_old)const
+  {
+    std::size_t hashes[LOOKUP_BLOCK];
+    this->hash_block(b, n, hashes, typename hashing_traits<hasher>::category());
+    if (this->TABLE_SIZE_ * sizeof(Element) >= PREFETCH_TABLE_BYTES)
+    {
+      for (size_type i = 0; i != n; ++i) this->prefetch_home(hashes[i], Probing());
+      for (size_type i = 0; i != n; ++i) this->prefetch_match(hashes[i], Probing());
+    }
+    for (size_type i = 0; i != n; ++i, ++b)
+    {
+      positions[i] = this->find_position(*b, hashes[i], Probing());
+      in_old[i] = false;
+      if (positions[i] == this->container_.size() && this->old_ != 0)
+      {
+        size_type j = this->old_->find_position(*b, hashes[i], Probing());
+        if (j != this->old_->container_.size())
+        {
+          positions[i] = j;
+          in_old[i] = true;
+        }
+      }
+    }
+  }
+  template <class iterator_t, class forward_iterator_t, class output_iterator_t>
+  output_iterator_t find_blocks(forward_iterator_t b, forward_iterator_t e, output_iterator_t out)const
+  {
+    size_type positions[LOOKUP_BLOCK];
+    bool in_old[LOOKUP_BLOCK];
+    while (b != e)
+    {
+      forward_iterator_t block = b;
+      size_type n = 0;
+      for (; b != e && n != LOOKUP_BLOCK; ++b) ++n;
+      this->find_block(block, n, positions, in_old);
+      for (size_type i = 0; i != n; ++i, ++out)
+      {
+        if (in_old[i]) *out = iterator_t(&this->old_->container_, positions[i], &this->container_);
+        else *out = iterator_t(&this->container_, positions[i]);
+      }
+    }
+    return out;
+  }
+
+  //Parallel bulk loading, see build(). The table is split into ranges of 
+  //slots that share no memory (whole bitmap words and control groups), to be
+  //filled at the same time, each with the elements whose probes start in it.
+  //An element whose probe would leave its range is left for later. 
+  enum {BUILD_PLACED, BUILD_DUPLICATE, BUILD_DEFERRED};
+  enum {BUILD_MIN_SIZE = 1 << 15, BUILD_CHUNKS = 256, BUILD_RANGES = 256};
+  size_type home_slot(size_type h, open_probing_tag)const
+  {
+    return growth_t::position(h, this->TABLE_SIZE_);
+  }
+  size_type home_slot(size_type h, robin_hood_probing_tag)const
+  {
+    return growth_t::position(h, this->TABLE_SIZE_);
+  }
+  size_type home_slot(size_type h, group_probing_tag)const
+  {
+    size_type h1;
+    ctrl_t h2;
+    this->split_hash(h, h1, h2);
+    return h1 * control_group::WIDTH;
+  }
+  //The table was empty when the build started, so there are no tombstones.
+  //Slots are filled without being counted.
+  template <class source_t>
+  int place_in_range(source_t& x, size_type h, size_type first, size_type last, 
+                     bool unique, open_probing_tag)
+  {
+    size_type hx = growth_t::position(h, this->TABLE_SIZE_);
+    size_type step = this->increment_(this->get_key_(x));
+    while (!this->container_[hx].is_null())
+    {
+      if (unique && this->holds(this->container_[hx], this->get_key_(x), h)) return BUILD_DUPLICATE;
+      hx = growth_t::next_position(hx, step, this->TABLE_SIZE_);
+      if (hx < first || hx >= last) return BUILD_DEFERRED;
+    }
+    this->fill_slot(hx, x, h);
+    return BUILD_PLACED;
+  }
+  template <class source_t>
+  int place_in_range(source_t& x, size_type h, size_type first, size_type last, 
+                     bool unique, group_probing_tag)
+  {
+    size_type h1;
+    ctrl_t h2;
+    this->split_hash(h, h1, h2);
+    ctrl_t* ctrl = this->container_.controls();
+    for (group_probe_sequence seq(h1, this->num_groups()); ; seq.next())
+    {
+      size_type offset = seq.offset();
+      if (offset < first || offset >= last) return BUILD_DEFERRED;
+      control_group group(ctrl + offset);
+      for (unsigned m = unique ? group.match(h2) : 0; m != 0; m &= m - 1)
+        if (this->holds(this->container_[offset + count_trailing_zeros(m)], this->get_key_(x), h)) 
+          return BUILD_DUPLICATE;
+      unsigned m = group.match_empty();
+      if (m != 0)
+      {
+        size_type hx = offset + count_trailing_zeros(m);
+        ctrl[hx] = h2;
+        this->fill_slot(hx, x, h);
+        return BUILD_PLACED;
+      }
+    }
+  }
+  template <class source_t>
+  int place_in_range(source_t& x, size_type h, size_type first, size_type last, 
+                     bool unique, robin_hood_probing_tag)
+  {
+    size_type hx = growth_t::position(h, this->TABLE_SIZE_);
+    size_type d = 0;
+    for (; ; ++d)
+    {
+      const Element& current = this->container_[hx];
+      if (current.is_null() || current.probe_distance() < d) break;
+      if (unique && this->holds(current, this->get_key_(x), h)) return BUILD_DUPLICATE;
+      hx = growth_t::next_position(hx, 1, this->TABLE_SIZE_);
+      if (hx < first || hx >= last) return BUILD_DEFERRED;
+    }
+    //The elements from hx on shift up to the next empty slot.
+    for (size_type i = hx; !this->container_[i].is_null(); )
+    {
+      i = growth_t::next_position(i, 1, this->TABLE_SIZE_);
+      if (i < first || i >= last) return BUILD_DEFERRED;
+    }
+    Element carry;
+    transfer_value(carry.value_, x);
+    carry.set_hash(h);
+    this->shift_in(hx, carry, d);
+    return BUILD_PLACED;
+  }
+
+  //Where build() and rehash() get their elements from: an input range, 
+  //copied from, or the occupied slots of the previous table, moved from.
+  template <class random_iterator_t>
+  void hash_sources(random_iterator_t b, size_type n, std::size_t* hashes)const
+  {
+    this->hash_values(b, n, hashes, typename hashing_traits<hasher>::category());
+  }
+  void hash_sources(Element** b, size_type n, std::size_t* hashes)const
+  {
+    for (size_type i = 0; i != n; ++i) hashes[i] = this->hash_of(*b[i]);
+  }
+  template <class random_iterator_t>
+  int place_source(random_iterator_t it, size_type h, size_type first, size_type last, bool unique)
+  {
+    const value_type& x = *it; //Copied, not moved from.
+    return this->place_in_range(x, h, first, last, unique, Probing());
+  }
+  int place_source(Element** it, size_type h, size_type first, size_type last, bool unique)
+  {
+    return this->place_in_range((*it)->value_, h, first, last, unique, Probing());
+  }
+  template <class random_iterator_t>
+  void insert_source(random_iterator_t it, size_type h, bool unique)
+  {
+    this->insert_hashed(*it, h, unique);
+  }
+  void insert_source(Element** it, size_type, bool){this->insert_absent(**it);}
+
+  //The steps of build(), run as tasks: hashing, counting and scattering work
+  //on chunks of the input, filling on ranges of slots.
+  template <class random_iterator_t>
+  struct BuildState
+  {
+    Self* table_;
+    random_iterator_t first_;
+    size_type size_;
+    size_type chunk_;
+    size_type range_;
+    size_type ranges_;
+    bool unique_;
+    std::vector<std::size_t> hashes_;
+    std::vector<size_type> counts_; //Chunk by range, then where each goes.
+    std::vector<size_type> order_; //Input positions, by range.
+    std::vector<size_type> range_begin_;
+    std::vector<size_type> placed_;
+    std::vector<std::vector<size_type> > deferred_;
+
+    size_type chunk_begin(size_type i)const{return std::min(i * this->chunk_, this->size_);}
+    size_type range_of(size_type j)const
+    {
+      return this->table_->home_slot(this->hashes_[j], Probing()) / this->range_;
+    }
+  };
+  template <class random_iterator_t>
+  struct HashTask
+  {
+    BuildState<random_iterator_t>& s_;
+    explicit HashTask(BuildState<random_iterator_t>& s):s_(s){}
+    void operator()(size_type i)
+    {
+      size_type e = this->s_.chunk_begin(i + 1);
+      for (size_type j = this->s_.chunk_begin(i); j < e; j += LOOKUP_BLOCK)
+        this->s_.table_->hash_sources(this->s_.first_ + j, std::min<size_type>(LOOKUP_BLOCK, e - j),
+                                      &this->s_.hashes_[j]);
+    }
+  };
+  template <class random_iterator_t>
+  struct CountTask
+  {
+    BuildState<random_iterator_t>& s_;
+    explicit CountTask(BuildState<random_iterator_t>& s):s_(s){}
+    void operator()(size_type i)
+    {
+      size_type* counts = &this->s_.counts_[i * this->s_.ranges_];
+      for (size_type j = this->s_.chunk_begin(i); j != this->s_.chunk_begin(i + 1); ++j)
+        ++counts[this->s_.range_of(j)];
+    }
+  };
+  template <class random_iterator_t>
+  struct ScatterTask
+  {
+    BuildState<random_iterator_t>& s_;
+    explicit ScatterTask(BuildState<random_iterator_t>& s):s_(s){}
+    void operator()(size_type i)
+    {
+      size_type* next = &this->s_.counts_[i * this->s_.ranges_];
+      for (size_type j = this->s_.chunk_begin(i); j != this->s_.chunk_begin(i + 1); ++j)
+        this->s_.order_[next[this->s_.range_of(j)]++] = j;
+    }
+  };
+  template <class random_iterator_t>
+  struct FillTask
+  {
+    BuildState<random_iterator_t>& s_;
+    explicit FillTask(BuildState<random_iterator_t>& s):s_(s){}
+    void operator()(size_type r)
+    {
+      size_type first = r * this->s_.range_;
+      size_type last = std::min(first + this->s_.range_, this->s_.table_->TABLE_SIZE_);
+      for (size_type i = this->s_.range_begin_[r]; i != this->s_.range_begin_[r + 1]; ++i)
+      {
+        size_type j = this->s_.order_[i];
+        int result = this->s_.table_->place_source(this->s_.first_ + j, this->s_.hashes_[j], 
+                                                   first, last, this->s_.unique_);
+        if (result == BUILD_PLACED) ++this->s_.placed_[r];
+        else if (result == BUILD_DEFERRED) this->s_.deferred_[r].push_back(j);
+      }
+    }
+  };
+  template <class container_t, class function_t>
+  static function_t visit_part(container_t& c, size_type i, size_type n, function_t f)
+  {
+    size_type first = i * (c.size() / n) + std::min(i, c.size() % n);
+    size_type last = first + c.size() / n + (i < c.size() % n);
+    for (size_type j = c.next_occupied(first); j < last; j = c.next_occupied(j + 1)) f(c[j].value_);
+    return f;
+  }
+  //The n elements from b go into the (empty) table, partitioned by where 
+  //their probes start.
+  template <class random_iterator_t, class runner_t>
+  void fill(random_iterator_t b, size_type n, bool unique, runner_t& run)
+  {
+    size_type align = std::max<size_type>(sizeof(std::size_t) * CHAR_BIT, control_group::WIDTH);
+    BuildState<random_iterator_t> s;
+    s.table_ = this;
+    s.first_ = b;
+    s.size_ = n;
+    s.chunk_ = (n + BUILD_CHUNKS - 1) / BUILD_CHUNKS;
+    s.range_ = (this->TABLE_SIZE_ / BUILD_RANGES + align - 1) / align * align;
+    s.ranges_ = (this->TABLE_SIZE_ + s.range_ - 1) / s.range_;
+    s.unique_ = unique;
+    s.hashes_.resize(n);
+    s.counts_.resize(BUILD_CHUNKS * s.ranges_, 0);
+    s.order_.resize(n);
+    s.range_begin_.resize(s.ranges_ + 1);
+    s.placed_.resize(s.ranges_, 0);
+    s.deferred_.resize(s.ranges_);
+
+    //Slots filled by the tasks are only counted once they are all done, so
+    //if one throws the table is emptied.
+    try
+    {
+      HashTask<random_iterator_t> hashing(s);
+      run(size_type(BUILD_CHUNKS), hashing);
+      CountTask<random_iterator_t> counting(s);
+      run(size_type(BUILD_CHUNKS), counting);
+      size_type total = 0;
+      for (size_type r = 0; r != s.ranges_; ++r)
+      {
+        s.range_begin_[r] = total;
+        for (size_type i = 0; i != BUILD_CHUNKS; ++i)
+        {
+          size_type c = s.counts_[i * s.ranges_ + r];
+          s.counts_[i * s.ranges_ + r] = total;
+          total += c;
+        }
+      }
+      s.range_begin_[s.ranges_] = total;
+      ScatterTask<random_iterator_t> scattering(s);
+      run(size_type(BUILD_CHUNKS), scattering);
+      FillTask<random_iterator_t> filling(s);
+      run(s.ranges_, filling);
+    }
+    catch (...)
+    {
+      this->clear();
+      throw;
+    }
+
+    for (size_type r = 0; r != s.ranges_; ++r)
+    {
+      this->NUM_ELEMENTS_ += s.placed_[r];
+      this->NUM_VALID_ELEMENTS_ += s.placed_[r];
+    }
+    for (size_type r = 0; r != s.ranges_; ++r)
+      for (size_type i = 0; i != s.deferred_[r].size(); ++i)
+      {
+        size_type j = s.deferred_[r][i];
+        this->insert_source(b + j, s.hashes_[j], unique);
+      }
+  }
+
+  template <class K>
+  size_type erase_key(const K& k, open_probing_tag)
+  {
+    size_type erased = 0;
+    size_type h = this->hash_(k);
+    size_type hx = growth_t::position(h, this->TABLE_SIZE_);
+    size_type step = this->increment_(k);
+    Element * current = &this->container_[hx];
+    while (!current->is_null())
+    {
+      if (current->is_available() && this->holds(*current, k, h))
+      {
+        this->erase_position(hx, open_probing_tag());
+        ++erased;
+      }
+      hx = growth_t::next_position(hx, step, this->TABLE_SIZE_);
+      current = &this->container_[hx];
+    }
+    return erased;
+  }
+  template <class K>
+  size_type erase_key(const K& k, robin_hood_probing_tag)
+  {
+    size_type erased = 0;
+    size_type h = this->hash_(k);
+    size_type hx = growth_t::position(h, this->TABLE_SIZE_);
+    for (size_type d = 0; ; )
+    {
+      const Element& current = this->container_[hx];
+      if (current.is_null() || current.probe_distance() < d) break;
+      if (this->holds(current, k, h))
+      {
+        this->erase_position(hx, robin_hood_probing_tag()); //Refills hx.
+        ++erased;
+        continue;
+      }
+      hx = growth_t::next_position(hx, 1, this->TABLE_SIZE_);
+      ++d;
+    }
+    return erased;
+  }
+  template <class K>
+  size_type erase_key(const K& k, group_probing_tag)
+  {
+    size_type erased = 0;
+    size_type h = this->hash_(k);
+    size_type h1;
+    ctrl_t h2;
+    this->split_hash(h, h1, h2);
+    const ctrl_t* ctrl = this->container_.controls();
+    for (group_probe_sequence seq(h1, this->num_groups()); ; seq.next())
+    {
+      control_group group(ctrl + seq.offset());
+      bool last = group.match_empty() != 0; //Before erasing empties the group.
+      for (unsigned m = group.match(h2); m != 0; m &= m - 1)
+      {
+        size_type i = seq.offset() + count_trailing_zeros(m);
+        if (this->holds(this->container_[i], k, h))
+        {
+          this->erase_position(i, group_probing_tag());
+          ++erased;
+        }
+      }
+      if (last) return erased;
+    }
+  }
+
+  //Calls f(i) for every position i that holds an element with key k, whose
+  //hash is h.
+  template <class K, class visitor_t>
+  void visit_equal(const K& k, size_type h, visitor_t& f, open_probing_tag)const
+  {
+    size_type hx = growth_t::position(h, this->TABLE_SIZE_);
+    size_type step = this->increment_(k);
+    for (; !this->container_[hx].is_null(); hx = growth_t::next_position(hx, step, this->TABLE_SIZE_))
+      if (this->container_[hx].is_available() && this->holds(this->container_[hx], k, h)) f(hx);
+  }
+  template <class K, class visitor_t>
+  void visit_equal(const K& k, size_type h, visitor_t& f, robin_hood_probing_tag)const
+  {
+    size_type hx = growth_t::position(h, this->TABLE_SIZE_);
+    for (size_type d = 0; ; ++d)
+    {
+      const Element& current = this->container_[hx];
+      if (current.is_null() || current.probe_distance() < d) return;
+      if (this->holds(current, k, h)) f(hx);
+      hx = growth_t::next_position(hx, 1, this->TABLE_SIZE_);
+    }
+  }
+  template <class K, class visitor_t>
+  void visit_equal(const K& k, size_type h, visitor_t& f, group_probing_tag)const
+  {
+    size_type h1;
+    ctrl_t h2;
+    this->split_hash(h, h1, h2);
+    const ctrl_t* ctrl = this->container_.controls();
+    for (group_probe_sequence seq(h1, this->num_groups()); ; seq.next())
+    {
+      control_group group(ctrl + seq.offset());
+      for (unsigned m = group.match(h2); m != 0; m &= m - 1)
+      {
+        size_type i = seq.offset() + count_trailing_zeros(m);
+        if (this->holds(this->container_[i], k, h)) f(i);
+      }
+      if (group.match_empty() != 0) return;
+    }
+  }
+
+  struct CountVisits
+  {
+    size_type count_;
+    CountVisits():count_(0){}
+    void operator()(size_type){++this->count_;}
+  };
+  template <class container_t, class function_t>
+  struct ApplyAt
+  {
+    container_t& container_;
+    function_t& f_;
+    ApplyAt(container_t& c, function_t& f):container_(c),f_(f){}
+    void operator()(size_type i){this->f_(this->container_[i].value_);}
+  };
+
+  //Where an equal_range() walk is: the slot of its current match, and how to
+  //go on probing from there. At the end, table_ is null.
+  struct EqualCursor
+  {
+    const Self* table_;
+    size_type position_;
+    size_type next_; //Open addressing and Robin Hood.
+    size_type probe_; //Step, probe distance, or 7 hash bits for group probing.
+    group_probe_sequence group_;
+    unsigned match_; //Group matches not visited yet.
+    bool last_; //The group has an empty slot.
+    EqualCursor():table_(0),position_(0),next_(0),probe_(0),group_(0, 1),match_(0),last_(false){}
+  };
+  void start_equal(EqualCursor& c, const key_type& k, size_type h)const
+  {
+    c.table_ = this;
+    this->start_match(c, k, h, Probing());
+    this->next_equal(c, k, h);
+  }
+  void next_equal(EqualCursor& c, const key_type& k, size_type h)const
+  {
+    for (const Self* t = this; !t->next_match(c, k, h, Probing()); )
+    {
+      t = t->old_;
+      c.table_ = t;
+      if (t == 0)
+      {
+        c.position_ = 0;
+        return;
+      }
+      t->start_match(c, k, h, Probing());
+    }
+  }
+  void start_match(EqualCursor& c, const key_type& k, size_type h, open_probing_tag)const
+  {
+    c.next_ = growth_t::position(h, this->TABLE_SIZE_);
+    c.probe_ = this->increment_(k);
+  }
+  bool next_match(EqualCursor& c, const key_type& k, size_type h, open_probing_tag)const
+  {
+    while (!this->container_[c.next_].is_null())
+    {
+      size_type i = c.next_;
+      c.next_ = growth_t::next_position(i, c.probe_, this->TABLE_SIZE_);
+      if (this->container_[i].is_available() && this->holds(this->container_[i], k, h))
+      {
+        c.position_ = i;
+        return true;
+      }
+    }
+    return false;
+  }
+  void start_match(EqualCursor& c, const key_type&, size_type h, robin_hood_probing_tag)const
+  {
+    c.next_ = growth_t::position(h, this->TABLE_SIZE_);
+    c.probe_ = 0;
+  }
+  bool next_match(EqualCursor& c, const key_type& k, size_type h, robin_hood_probing_tag)const
+  {
+    for (; ; ++c.probe_)
+    {
+      const Element& current = this->container_[c.next_];
+      if (current.is_null() || current.probe_distance() < c.probe_) return false;
+      size_type i = c.next_;
+      c.next_ = growth_t::next_position(i, 1, this->TABLE_SIZE_);
+      if (this->holds(current, k, h))
+      {
+        c.position_ = i;
+        ++c.probe_;
+        return true;
+      }
+    }
+  }
+  void start_match(EqualCursor& c, const key_type&, size_type h, group_probing_tag)const
+  {
+    size_type h1;
+    ctrl_t h2;
+    this->split_hash(h, h1, h2);
+    c.probe_ = h2;
+    c.group_ = group_probe_sequence(h1, this->num_groups());
+    control_group group(this->container_.controls() + c.group_.offset());
+    c.match_ = group.match(h2);
+    c.last_ = group.match_empty() != 0;
+  }
+  bool next_match(EqualCursor& c, const key_type& k, size_type h, group_probing_tag)const
+  {
+    for (; ; )
+    {
+      for (; c.match_ != 0; c.match_ &= c.match_ - 1)
+      {
+        size_type i = c.group_.offset() + count_trailing_zeros(c.match_);
+        if (this->holds(this->container_[i], k, h))
+        {
+          c.position_ = i;
+          c.match_ &= c.match_ - 1;
+          return true;
+        }
+      }
+      if (c.last_) return false;
+      c.group_.next();
+      control_group group(this->container_.controls() + c.group_.offset());
+      c.match_ = group.match(ctrl_t(c.probe_));
+      c.last_ = group.match_empty() != 0;
+    }
+  }
+
+  //Comparison helpers. Counts the visited elements equal to value_.
+  struct CountCopies
+  {
+    const Container& container_;
+    const value_type& value_;
+    size_type count_;
+    CountCopies(const Container& c, const value_type& v):container_(c),value_(v),count_(0){}
+    void operator()(size_type i){if (this->container_[i].value_ == this->value_) ++this->count_;}
+  };
+  //Elements equal to v, whose key hashes to h, here and in the table being 
+  //drained.
+  size_type count_copies(const value_type& v, size_type h)const
+  {
+    size_type n = 0;
+    for (const Self* t = this; t != 0; t = t->old_)
+    {
+      CountCopies f(t->container_, v);
+      t->visit_equal(t->get_key_(v), h, f, Probing());
+      n += f.count_;
+    }
+    return n;
+  }
+  //Whether other (of the same size) has equal elements in the same slots, as
+  //copies do.
+  bool same_layout(const Self& other)const
+  {
+    if (this->old_ != 0 || other.old_ != 0 || this->TABLE_SIZE_ != other.TABLE_SIZE_) return false;
+    const Container& a = this->container_;
+    const Container& b = other.container_;
+    for (size_type i = a.next_occupied(0); i != a.size(); i = a.next_occupied(i + 1))
+    {
+      if (b.next_occupied(i) != i || !a[i].may_equal(b[i]) || !(a[i].value_ == b[i].value_)) 
+        return false;
+    }
+    return true;
+  }
+  //Whether every element is as many times in other (of the same size).
+  bool same_elements(const Self& other)const
+  {
+    for (const Self* t = this; t != 0; t = t->old_)
+    {
+      const Container& c = t->container_;
+      for (size_type i = c.next_occupied(0); i != c.size(); i = c.next_occupied(i + 1))
+      {
+        size_type h = t->hash_of(c[i]);
+        if (this->count_copies(c[i].value_, h) != other.count_copies(c[i].value_, h)) return false;
+      }
+    }
+    return true;
+  }
+
+  //Called when the load limit is reached. If live elements are less than half
+  //of the load, dropping the unavailable slots makes enough room.
+  void make_room()
+  {
+    if (this->NUM_VALID_ELEMENTS_ <= this->MAX_ELEMENTS_/2) this->compact();
+    else this->expand();
+  }
+
+  //In place rehash. Every element is first marked as pending, then moved to
+  //the first slot of its probe sequence that is empty or still pending 
+  //(swapping with the pending element found there). Slots that come before
+  //it in the sequence are settled for good, so lookups find it there.
+  void swap_elements(Element& a, Element& b)
+  {
+    swap_values(a.value_, b.value_);
+    a.swap_hash(b);
+    std::swap(a.state_, b.state_);
+  }
+  void compact(open_probing_tag)
+  {
+    for (size_type i = 0; i < this->TABLE_SIZE_; ++i)
+    {
+      Element& current = this->container_[i];
+      if (!current.is_available()) current = Element();
+      else if (!current.is_null()) current.make_unavailable(); //Pending.
+    }
+    for (size_type i = 0; i < this->TABLE_SIZE_; ++i)
+    {
+      while (!this->container_[i].is_null() && !this->container_[i].is_available())
+      {
+        const key_type& k = this->get_key_(this->container_[i].value_);
+        size_type hx = growth_t::position(this->hash_of(this->container_[i]), this->TABLE_SIZE_);
+        size_type step = this->increment_(k);
+        while (this->container_[hx].is_available() && !this->container_[hx].is_null())
+          hx = growth_t::next_position(hx, step, this->TABLE_SIZE_);
+        if (hx == i)
+        {
+          this->container_[i].state_ = Element::FULL;
+        }
+        else if (this->container_[hx].is_null())
+        {
+          this->swap_elements(this->container_[hx], this->container_[i]);
+          this->container_[hx].state_ = Element::FULL;
+          this->container_.set_occupied(hx);
+          this->container_.clear_occupied(i);
+        }
+        else
+        {
+          this->swap_elements(this->container_[hx], this->container_[i]);
+          this->container_[hx].state_ = Element::FULL;
+        }
+      }
+    }
+    this->NUM_ELEMENTS_ = this->NUM_VALID_ELEMENTS_;
+  }
+  void compact(robin_hood_probing_tag)
+  {
+    //Nothing to do, erasure never leaves unavailable slots.
+  }
+  void compact(group_probing_tag)
+  {
+    ctrl_t* ctrl = this->container_.controls();
+    for (size_type i = 0; i < this->TABLE_SIZE_; ++i)
+    {
+      if (ctrl[i] == CTRL_DELETED)
+      {
+        ctrl[i] = CTRL_EMPTY;
+        this->container_[i] = Element();
+      }
+      else if (ctrl[i] != CTRL_EMPTY) ctrl[i] = CTRL_DELETED; //Pending.
+    }
+    for (size_type i = 0; i < this->TABLE_SIZE_; ++i)
+    {
+      while (ctrl[i] == CTRL_DELETED)
+      {
+        size_type h1;
+        ctrl_t h2;
+        this->split_hash(this->hash_of(this->container_[i]), h1, h2);
+        size_type hx = this->find_free_position(h1);
+        if (hx / control_group::WIDTH == i / control_group::WIDTH)
+        {
+          ctrl[i] = h2; //Already in the right group.
+        }
+        else if (ctrl[hx] == CTRL_EMPTY)
+        {
+          this->swap_elements(this->container_[hx], this->container_[i]);
+          ctrl[hx] = h2;
+          ctrl[i] = CTRL_EMPTY;
+          this->container_.set_occupied(hx);
+          this->container_.clear_occupied(i);
+        }
+        else
+        {
+          this->swap_elements(this->container_[hx], this->container_[i]);
+          ctrl[hx] = h2;
+        }
+      }
+    }
+    this->NUM_ELEMENTS_ = this->NUM_VALID_ELEMENTS_;
+  }
+
+  template <class Tag>
+  void erase_range(iterator b, iterator e, Tag)
+  {
+    for (; b != e; ++b) this->erase(b);
+  }
+  void erase_range(iterator b, iterator e, robin_hood_probing_tag)
+  {
+    //Backwards from an empty slot, wrapping around the range, so the shifts
+    //only move elements into slots already visited: a shift stops at an 
+    //empty slot, and this one stays empty. If the range has none, there is
+    //one after it before the walk could wrap back into it.
+    size_type z = b.current_;
+    while (z != e.current_ && !this->container_[z].is_null()) ++z;
+    for (size_type i = z; i-- > b.current_; )
+      if (!this->container_[i].is_null()) this->erase_position(i, robin_hood_probing_tag());
+    for (size_type i = e.current_; i > z + 1; )
+      if (!this->container_[--i].is_null()) this->erase_position(i, robin_hood_probing_tag());
+  }
+
+  void reinit(size_type table_size)
+  {
+    Container slots(table_size, grouped(Probing()));
+    this->reinit(table_size, slots);
+  }
+  void reinit(size_type table_size, Container& slots)
+  {
+    this->NUM_ELEMENTS_ = 0;
+    this->NUM_VALID_ELEMENTS_ = 0;
+    this->TABLE_SIZE_ = table_size;
+    this->MAX_ELEMENTS_ = this->load_limit(table_size);
+    slots.swap(this->container_);
+  }
+  void clear_migration()
+  {
+    delete this->old_;
+    this->old_ = 0;
+  }
+
+  //The slots as save() writes them, into zeroed memory: the state of each,
+  //the hash and value of full ones only (snapshot.h).
+  static void copy_slots(const void* data, std::size_t first, std::size_t n, unsigned char* out)
+  {
+    const Element* e = static_cast<const Element*>(data) + first;
+    for (std::size_t i = 0; i != n; ++i, ++e, out += sizeof(Element))
+    {
+      copy_field(*e, e->state_, out);
+      if (e->is_null() || !e->is_available()) continue;
+      copy_field(*e, e->value_, out);
+      copy_hash(*e, *e, out);
+    }
+  }
+  template <class T>
+  static void copy_field(const Element& e, const T& field, unsigned char* out)
+  {
+    std::size_t offset = reinterpret_cast<const unsigned char*>(&field) - reinterpret_cast<const unsigned char*>(&e);
+    std::memcpy(out + offset, &field, sizeof(T));
+  }
+  static void copy_hash(const Element&, const hash_slot__<false>&, unsigned char*){}
+  static void copy_hash(const Element& e, const hash_slot__<true>& slot, unsigned char* out)
+  {
+    copy_field(e, slot.stored_hash_, out);
+  }
+
+public:
+  hash_table__(size_type max):
+    TABLE_SIZE_(capacity_for(max, growth_t::max_load_factor())),NUM_ELEMENTS_(0),NUM_VALID_ELEMENTS_(0),
+    MAX_LOAD_FACTOR_(growth_t::max_load_factor()),MAX_ELEMENTS_(load_limit(TABLE_SIZE_)),
+    container_(TABLE_SIZE_, grouped(Probing())),old_(0),MIGRATION_POSITION_(0),
+    spare_(0, grouped(Probing())){}
+  hash_table__(size_type max, const hasher& h):
+    TABLE_SIZE_(capacity_for(max, growth_t::max_load_factor())),NUM_ELEMENTS_(0),NUM_VALID_ELEMENTS_(0),
+    MAX_LOAD_FACTOR_(growth_t::max_load_factor()),MAX_ELEMENTS_(load_limit(TABLE_SIZE_)),
+    container_(TABLE_SIZE_, grouped(Probing())),old_(0),MIGRATION_POSITION_(0),
+    spare_(0, grouped(Probing())),hash_(h){}
+  hash_table__(size_type max, const hasher& h, const key_equal& eq):
+    TABLE_SIZE_(capacity_for(max, growth_t::max_load_factor())),NUM_ELEMENTS_(0),NUM_VALID_ELEMENTS_(0),
+    MAX_LOAD_FACTOR_(growth_t::max_load_factor()),MAX_ELEMENTS_(load_limit(TABLE_SIZE_)),
+    container_(TABLE_SIZE_, grouped(Probing())),old_(0),MIGRATION_POSITION_(0),
+    spare_(0, grouped(Probing())),hash_(h),key_equals_(eq){}
+  hash_table__(const Self& other):
+    TABLE_SIZE_(other.TABLE_SIZE_),NUM_ELEMENTS_(other.NUM_ELEMENTS_),
+    NUM_VALID_ELEMENTS_(other.NUM_VALID_ELEMENTS_),MAX_LOAD_FACTOR_(other.MAX_LOAD_FACTOR_),
+    MAX_ELEMENTS_(other.MAX_ELEMENTS_),container_(other.container_),
+    old_(other.old_ != 0 ? new Self(*other.old_) : 0),MIGRATION_POSITION_(other.MIGRATION_POSITION_),
+    spare_(0, grouped(Probing())),
+    hash_(other.hash_),increment_(other.increment_),key_equals_(other.key_equals_),get_key_(other.get_key_){}
+  ~hash_table__(){delete this->old_;}
+
+  Self& operator=(const Self& other)
+  {
+    Self copy(other);
+    this->swap(copy);
+    return *this;
+  }
+
+
+  //Getters.
+  hasher hash_funct()const{return this->hash_;}
+  key_equal key_eq()const{return this->key_equals_;}
+  
+  void swap(Self& other)
+  {
+    std::swap(this->TABLE_SIZE_, other.TABLE_SIZE_);
+    std::swap(this->NUM_ELEMENTS_, other.NUM_ELEMENTS_);
+    std::swap(this->NUM_VALID_ELEMENTS_, other.NUM_VALID_ELEMENTS_);
+    std::swap(this->MAX_LOAD_FACTOR_, other.MAX_LOAD_FACTOR_);
+    std::swap(this->MAX_ELEMENTS_, other.MAX_ELEMENTS_);
+    this->container_.swap(other.container_); //Constant for vector.
+    std::swap(this->old_, other.old_);
+    std::swap(this->MIGRATION_POSITION_, other.MIGRATION_POSITION_);
+    this->spare_.swap(other.spare_);
+    std::swap(this->hash_, other.hash_);
+    std::swap(this->increment_, other.increment_);
+    std::swap(this->key_equals_, other.key_equals_);
+    std::swap(this->get_key_, other.get_key_);
+  }
+  
+  std::pair<iterator, bool> insert_unique(const value_type& x)
+  {
+    return this->insert_unique_value(x, this->hash_(this->get_key_(x)));
+  }
+  iterator insert_equal(const value_type& x)
+  {
+    return this->insert_equal_value(x, this->hash_(this->get_key_(x)));
+  }
+#ifdef HASHCOL_HAS_CXX11
+  std::pair<iterator, bool> insert_unique(value_type&& x)
+  {
+    return this->insert_unique_value(x, this->hash_(this->get_key_(x)));
+  }
+  iterator insert_equal(value_type&& x)
+  {
+    return this->insert_equal_value(x, this->hash_(this->get_key_(x)));
+  }
+#endif
+  //Inserts make(k) unless there is an element with key k already. The 
+  //element is only made if it is inserted, after a single lookup.
+  template <class K, class maker_t>
+  std::pair<iterator, bool> insert_unique_key(const K& k, maker_t make)
+  {
+    Slot s;
+    std::pair<iterator, bool> r = this->prepare_unique(k, this->hash_(k), s);
+    if (!r.second) return r;
+    value_type x(make(k));
+    this->place(s, x, Probing());
+    return std::make_pair(iterator(&this->container_, s.position_), true);
+  }
+  template <class input_iterator_t>
+  void insert_unique(input_iterator_t b, input_iterator_t e)
+  {
+    this->insert_range(b, e, true, typename std::iterator_traits<input_iterator_t>::iterator_category());
+  }
+  template <class input_iterator_t>
+  void insert_equal(input_iterator_t b, input_iterator_t e)
+  {
+    this->insert_range(b, e, false, typename std::iterator_traits<input_iterator_t>::iterator_category());
+  }
+
+  //Replaces the elements with those of [b, e), as insert_unique(b, e) or
+  //insert_equal(b, e) would, but split into tasks that may run in parallel:
+  //run(n, task) must call task(i) for every i in [0, n) and return when all
+  //are done (parallel_build.h). Equal keys always end up in the same task, 
+  //so no locking is needed, and the first of them is the one kept. If run 
+  //throws, the table is left empty.
+  template <class random_iterator_t, class runner_t>
+  void build(random_iterator_t b, random_iterator_t e, bool unique, runner_t& run)
+  {
+    this->clear();
+    size_type n = e - b;
+    this->reserve(n);
+    if (n < BUILD_MIN_SIZE) this->insert_range(b, e, unique, std::random_access_iterator_tag());
+    else this->fill(b, n, unique, run);
+  }
+
+  //rehash(n), with the elements moved over in tasks as build() does. Small
+  //tables are rehashed on the calling thread. If run throws, the elements 
+  //are lost and the table is left empty.
+  template <class runner_t>
+  void rehash(size_type n, runner_t& run)
+  {
+    size_type t = std::max(table_size(n, Probing()), capacity_for(this->size(), this->MAX_LOAD_FACTOR_));
+    if (this->size() < BUILD_MIN_SIZE)
+    {
+      this->resize_table(t);
+      return;
+    }
+    std::vector<Element*> elements;
+    elements.reserve(this->size());
+    Container old(0, grouped(Probing()));
+    old.swap(this->container_);
+    for (size_type i = old.next_occupied(0); i != old.size(); i = old.next_occupied(i + 1))
+      elements.push_back(&old[i]);
+    if (this->old_ != 0)
+    {
+      Container& rest = this->old_->container_;
+      for (size_type i = rest.next_occupied(0); i != rest.size(); i = rest.next_occupied(i + 1))
+        elements.push_back(&rest[i]);
+    }
+    this->reinit(t);
+    this->fill(&elements[0], elements.size(), false, run);
+    this->clear_migration();
+    Container(0, grouped(Probing())).swap(this->spare_);
+  }
+
+  //Range-splittable traversal: part i of n visits the elements in the i-th 
+  //of n equal ranges of slots (of both tables while resizing incrementally),
+  //so the parts together visit every element once. Different parts can be 
+  //visited at the same time, if f does not modify the table 
+  //(parallel_algorithm.h).
+  template <class function_t>
+  function_t for_each_part(size_type i, size_type n, function_t f)
+  {
+    if (this->old_ == 0) return visit_part(this->container_, i, n, f);
+    return visit_part(this->old_->container_, i, n, visit_part(this->container_, i, n, f));
+  }
+  template <class function_t>
+  function_t for_each_part(size_type i, size_type n, function_t f)const
+  {
+    if (this->old_ == 0) return visit_part(this->container_, i, n, f);
+    return visit_part(this->old_->container_, i, n, visit_part(this->container_, i, n, f));
+  }
+
+  //Erasing does not move elements between tables, so it keeps its iterator
+  //guarantees while resizing incrementally.
+  void erase(iterator it)
+  { 
+    if (it.container_ == &this->container_) this->erase_position(it.current_, Probing());
+    else this->old_->erase_position(it.current_, Probing());
+  }
+  void erase(const_iterator it){this->erase(iterator(it.container_, it.current_));}
+  void erase(iterator b, iterator e)
+  {
+    if (this->old_ != 0 && b.container_ == &this->old_->container_)
+    {
+      iterator old_b(b.container_, b.current_);
+      if (e.container_ == b.container_) 
+      {
+        this->old_->erase(old_b, e);
+        return;
+      }
+      this->old_->erase(old_b, this->old_->end());
+      this->erase_range(iterator(&this->container_, this->container_.next_occupied(0)), e, Probing());
+      return;
+    }
+    this->erase_range(b, e, Probing());
+  }
+  template <class K>
+  size_type erase(const K& k) //Could implement "erase_unique"
+    //with a break inside the loop for better performance in unique containers.
+  {
+    size_type erased = this->erase_key(k, Probing());
+    if (this->old_ != 0) erased += this->old_->erase(k);
+    return erased;
+  }
+
+  template <class K>
+  iterator find(const K& k)
+  {
+    size_type i = this->find_position(k);
+    if (i == this->container_.size() && this->old_ != 0)
+    {
+      size_type j = this->old_->find_position(k);
+      if (j != this->old_->container_.size()) return this->old_iterator(j);
+    }
+    return iterator(&this->container_, i);
+  }
+  template <class K>
+  const_iterator find(const K& k)const
+  {
+    size_type i = this->find_position(k);
+    if (i == this->container_.size() && this->old_ != 0)
+    {
+      size_type j = this->old_->find_position(k);
+      if (j != this->old_->container_.size()) return this->old_iterator(j);
+    }
+    return const_iterator(&this->container_, i);
+  }
+  //find() for each key in [b, e), in order, written to out. The range is 
+  //read twice, a block at a time: once to hash and prefetch, once to probe.
+  template <class forward_iterator_t, class output_iterator_t>
+  output_iterator_t find_many(forward_iterator_t b, forward_iterator_t e, output_iterator_t out)
+  {
+    return this->template find_blocks<iterator>(b, e, out);
+  }
+  template <class forward_iterator_t, class output_iterator_t>
+  output_iterator_t find_many(forward_iterator_t b, forward_iterator_t e, output_iterator_t out)const
+  {
+    return this->template find_blocks<const_iterator>(b, e, out);
+  }
+  //Whether each key in [b, e) is in the table, written to out.
+  template <class forward_iterator_t, class output_iterator_t>
+  output_iterator_t contains_many(forward_iterator_t b, forward_iterator_t e, output_iterator_t out)const
+  {
+    size_type positions[LOOKUP_BLOCK];
+    bool in_old[LOOKUP_BLOCK];
+    while (b != e)
+    {
+      forward_iterator_t block = b;
+      size_type n = 0;
+      for (; b != e && n != LOOKUP_BLOCK; ++b) ++n;
+      this->find_block(block, n, positions, in_old);
+      for (size_type i = 0; i != n; ++i, ++out)
+        *out = in_old[i] || positions[i] != this->container_.size();
+    }
+    return out;
+  }
+
+  size_type size()const
+  {
+    return this->NUM_VALID_ELEMENTS_ + (this->old_ != 0 ? this->old_->NUM_VALID_ELEMENTS_ : 0);
+  }
+  size_type max_size()const{return this->container_.max_size();}
+  size_type bucket_count()const{return this->TABLE_SIZE_;}
+  bool empty()const{return 0 == this->size();}
+  void resize(size_type n)
+  {
+    if (n > this->TABLE_SIZE_) 
+      this->resize_table(std::max(table_size(n, Probing()), 
+                                  capacity_for(this->size(), this->MAX_LOAD_FACTOR_)));
+  }
+
+  float load_factor()const{return float(this->size()) / this->TABLE_SIZE_;}
+  float max_load_factor()const{return this->MAX_LOAD_FACTOR_;}
+  void max_load_factor(float z)
+  {
+    this->MAX_LOAD_FACTOR_ = z;
+    this->MAX_ELEMENTS_ = this->load_limit(this->TABLE_SIZE_);
+  }
+  //Room for n elements without growing (tombstones are purged if they are 
+  //in the way).
+  void reserve(size_type n)
+  {
+    size_type t = capacity_for(std::max(n, this->size()), this->MAX_LOAD_FACTOR_);
+    if (t > this->TABLE_SIZE_ || this->old_ != 0) this->resize_table(std::max(t, this->TABLE_SIZE_));
+    else if (n + (this->NUM_ELEMENTS_ - this->NUM_VALID_ELEMENTS_) > this->MAX_ELEMENTS_) 
+      this->compact();
+  }
+  //At least n buckets and room for the current elements. May shrink.
+  void rehash(size_type n)
+  {
+    this->resize_table(std::max(table_size(n, Probing()), 
+                                capacity_for(this->size(), this->MAX_LOAD_FACTOR_)));
+  }
+  void clear()
+  {
+    this->clear_migration();
+    this->reinit(this->TABLE_SIZE_);
+  }
+  void compact(){this->compact(Probing());}
+
+  //Writes the slots to path, to be mapped by mapped_hash_table__ 
+  //(snapshot.h). Elements must be trivially copyable. Returns whether the
+  //file could be written.
+  bool save(const char* path)const
+  {
+    if (this->old_ != 0)
+    {
+      Self copy(*this);
+      copy.rehash(0);
+      return copy.save(path);
+    }
+    snapshot_header h;
+    h.layout_ = snapshot_layout(typeid(Self).name());
+    h.probing_ = probing_id(Probing());
+    h.element_size_ = sizeof(Element);
+    h.table_size_ = this->TABLE_SIZE_;
+    h.num_elements_ = this->NUM_ELEMENTS_;
+    h.num_valid_elements_ = this->NUM_VALID_ELEMENTS_;
+    snapshot_region regions[3];
+    regions[0].data_ = &this->container_[0];
+    regions[0].size_ = this->TABLE_SIZE_ * sizeof(Element);
+    regions[0].item_size_ = sizeof(Element);
+    regions[0].copy_ = &Self::copy_slots;
+    regions[1].data_ = grouped(Probing()) ? this->container_.controls() : 0;
+    regions[1].size_ = grouped(Probing()) ? this->TABLE_SIZE_ : 0;
+    regions[2].data_ = this->container_.occupied_words();
+    regions[2].size_ = this->container_.num_occupied_words() * sizeof(std::size_t);
+    return write_snapshot(path, h, regions);
+  }
+
+  //Probe lengths, clusters and home bucket occupancy (hash_statistics.h).
+  //The keys in [b, e) that are not in the table are looked up as misses. 
+  //Elements still waiting to be moved by an incremental resize are left out.
+  table_statistics statistics()const
+  {
+    const key_type* none = 0;
+    return this->statistics(none, none);
+  }
+  template <class input_iterator_t>
+  table_statistics statistics(input_iterator_t b, input_iterator_t e)const
+  {
+    table_statistics s;
+    s.buckets_ = this->TABLE_SIZE_;
+    s.elements_ = this->NUM_VALID_ELEMENTS_;
+    s.tombstones_ = this->NUM_ELEMENTS_ - this->NUM_VALID_ELEMENTS_;
+    std::vector<size_type> occupancy(this->num_buckets(Probing()), 0);
+    for (size_type i = this->container_.next_occupied(0); 
+         i != this->container_.size(); 
+         i = this->container_.next_occupied(i + 1))
+    {
+      const key_type& k = this->get_key_(this->container_[i].value_);
+      s.hits_.add(this->probe_length(k, Probing()));
+      ++occupancy[this->home_bucket(k, Probing())];
+    }
+    s.chi_square_ = occupancy_chi_square(occupancy);
+    s.degrees_of_freedom_ = occupancy.size() - 1;
+    for (; b != e; ++b)
+      if (this->find_position(*b) == this->container_.size())
+        s.misses_.add(this->probe_length(*b, Probing()));
+    //Clusters may wrap around, so the walk starts right after an empty slot.
+    size_type start = 0;
+    while (start != this->TABLE_SIZE_ && !this->container_[start].is_null()) ++start;
+    size_type run = 0;
+    for (size_type j = 1; j <= this->TABLE_SIZE_; ++j)
+    {
+      size_type i = (start + j) % this->TABLE_SIZE_;
+      if (!this->container_[i].is_null()) ++run;
+      else if (run != 0)
+      {
+        s.clusters_.add(run);
+        run = 0;
+      }
+    }
+    if (run != 0) s.clusters_.add(run);
+    return s;
+  }
+
+  //count(), equal_range() and for_each_equal() only walk the probe sequence
+  //of the key.
+  template <class K>
+  size_type count(const K& k)const
+  { 
+    size_type h = this->hash_(k);
+    CountVisits f;
+    for (const Self* t = this; t != 0; t = t->old_) t->visit_equal(k, h, f, Probing());
+    return f.count_;
+  }
+  std::pair<equal_iterator, equal_iterator> equal_range(const key_type& k)
+  {
+    return std::make_pair(equal_iterator(this, k, this->hash_(k)), equal_iterator());
+  }
+  std::pair<const_equal_iterator, const_equal_iterator> equal_range(const key_type& k)const
+  {
+    return std::make_pair(const_equal_iterator(this, k, this->hash_(k)), const_equal_iterator());
+  }
+  template <class K, class function_t>
+  function_t for_each_equal(const K& k, function_t f)
+  {
+    size_type h = this->hash_(k);
+    for (Self* t = this; t != 0; t = t->old_)
+    {
+      ApplyAt<Container, function_t> a(t->container_, f);
+      t->visit_equal(k, h, a, Probing());
+    }
+    return f;
+  }
+  template <class K, class function_t>
+  function_t for_each_equal(const K& k, function_t f)const
+  {
+    size_type h = this->hash_(k);
+    for (const Self* t = this; t != 0; t = t->old_)
+    {
+      ApplyAt<const Container, function_t> a(t->container_, f);
+      t->visit_equal(k, h, a, Probing());
+    }
+    return f;
+  }
+
+  iterator begin()
+  {
+    if (this->old_ != 0) return this->old_iterator(this->old_->container_.next_occupied(0));
+    return iterator(&this->container_, this->container_.next_occupied(0));
+  }
+  iterator end()
+  {
+    return iterator(&this->container_, this->container_.size());
+  }
+  const_iterator begin()const
+  {
+    if (this->old_ != 0) return this->old_iterator(this->old_->container_.next_occupied(0));
+    return const_iterator(&this->container_, this->container_.next_occupied(0));
+  }
+  const_iterator end()const
+  {
+    return const_iterator(&this->container_, this->container_.size());
+  }
+
+  template <class K, class V, class H, class I, class E, class G, class A, class P>
+  friend bool 
+  operator==(const hash_table__<K, V, H, I, E, G, A, P>& l, 
+             const hash_table__<K, V, H, I, E, G, A, P>& r);
+
+};
+
+template <
+  class key_t, 
+  class value_t, 
+  class hash_fcn_t,
+  class increment_t,
+  class equal_key_t,
+  class get_key_t,
+  class alloc_t,
+  class growth_t> 
+void
+hash_table__<
+  key_t,
+  value_t,
+  hash_fcn_t,
+  increment_t,
+  equal_key_t,
+  get_key_t,
+  alloc_t,
+  growth_t>::
+resize_table(size_type table_size)
+{
+  #ifdef DEBUG
+    std::cout << "\nEXPANDINDO TABELA DE HASH...";
+  #endif 
+
+  //Elements are moved out of the old slots, and go in unconditionally: the
+  //old table already settled which of them belong, so no keys are compared.
+  //An incremental resize in progress is finished on the way.
+  Container old(0, grouped(Probing()));
+  old.swap(this->container_);
+  this->reinit(table_size);  
+  for (size_type i = old.next_occupied(0); i != old.size(); i = old.next_occupied(i + 1))
+    this->insert_absent(old[i]);
+  if (this->old_ != 0)
+  {
+    Container& rest = this->old_->container_;
+    for (size_type i = rest.next_occupied(0); i != rest.size(); i = rest.next_occupied(i + 1))
+      this->insert_absent(rest[i]);
+    this->clear_migration();
+  }
+  Container(0, grouped(Probing())).swap(this->spare_);
+}
+
+//Tables are equal if they have the same elements, as many times each, 
+//wherever they are. Copies are recognized slot by slot; otherwise every 
+//element is looked up in both tables, using its stored hash if there is one.
+template <class K, class V, class H, class I, class E, class G, class A, class P>
+inline bool 
+operator==(const hash_table__<K, V, H, I, E, G, A, P>& l, 
+           const hash_table__<K, V, H, I, E, G, A, P>& r)
+{
+  return l.size() == r.size() && (l.same_layout(r) || l.same_elements(r));
 }
 
 
@@ -0,0 +1,148 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef HASHCOL_HUGE_PAGE_ALLOCATOR_H
+#define HASHCOL_HUGE_PAGE_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include "config.h"
+
+#if defined(__linux__)
+  #include <sys/mman.h>
+#endif
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+/**********************************************************************************
+
+NOTES:
+
+  - Random probes into a table much larger than the TLB reach miss on the 
+  page walk as well as on the cache. With 2 MB pages the same TLB covers 512
+  times as much memory.
+
+  - On Linux, blocks of at least HUGE_PAGE_SIZE are mapped with MAP_HUGETLB
+  (pages reserved by the administrator, vm.nr_hugepages). If there are none,
+  they are mapped normally and marked MADV_HUGEPAGE, which lets transparent
+  huge pages back them when enabled ("madvise" or "always" mode). Smaller 
+  blocks, and all blocks elsewhere, come from operator new.
+
+  - Mapped blocks are rounded up to whole huge pages, so the allocator suits
+  table storage, a few big blocks, rather than many small ones.
+
+***********************************************************************************/
+
+template <class T>
+class huge_page_allocator
+{
+public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+  template <class U>
+  struct rebind
+  {
+    typedef huge_page_allocator<U> other;
+  };
+
+  enum {HUGE_PAGE_SIZE = 1 << 21};
+
+  huge_page_allocator(){}
+  template <class U>
+  huge_page_allocator(const huge_page_allocator<U>&){}
+
+  pointer allocate(size_type n, const void* = 0)
+  {
+    std::size_t bytes = n * sizeof(T);
+#if defined(__linux__)
+    if (bytes >= HUGE_PAGE_SIZE)
+    {
+      bytes = rounded(bytes);
+      void* p = MAP_FAILED;
+  #ifdef MAP_HUGETLB
+      p = ::mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  #endif
+      if (p == MAP_FAILED) 
+      {
+        p = ::mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+  #ifdef MADV_HUGEPAGE
+        ::madvise(p, bytes, MADV_HUGEPAGE);
+  #endif
+      }
+      return static_cast<pointer>(p);
+    }
+#endif
+    return static_cast<pointer>(::operator new(bytes));
+  }
+  void deallocate(pointer p, size_type n)
+  {
+#if defined(__linux__)
+    std::size_t bytes = n * sizeof(T);
+    if (bytes >= HUGE_PAGE_SIZE)
+    {
+      ::munmap(p, rounded(bytes));
+      return;
+    }
+#else
+    (void)n;
+#endif
+    ::operator delete(p);
+  }
+  size_type max_size()const{return size_type(-1) / sizeof(T);}
+#ifndef HASHCOL_HAS_CXX11
+  //Construction is left to std::allocator_traits otherwise.
+  pointer address(reference x)const{return &x;}
+  const_pointer address(const_reference x)const{return &x;}
+  void construct(pointer p, const T& x){new (p) T(x);}
+  void destroy(pointer p){p->~T();}
+#endif
+
+private:
+  static std::size_t rounded(std::size_t bytes)
+  {
+    return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  }
+};
+
+template <class T, class U>
+inline bool operator==(const huge_page_allocator<T>&, const huge_page_allocator<U>&){return true;}
+template <class T, class U>
+inline bool operator!=(const huge_page_allocator<T>&, const huge_page_allocator<U>&){return false;}
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_HUGE_PAGE_ALLOCATOR_H
@@ -28,15 +28,21 @@
 #ifndef HASHCOL_INCREMENT_H
 #define HASHCOL_INCREMENT_H
 
+#include <cstring>
+#include <string>
+
+#include "hash_function.h"
+
 HASHCOL_BEGIN_NAMESPACE
 
 
-//For linear probing.
+//For linear probing. Takes any key-like type, for heterogeneous lookups.
 
 template <class key_t>
 struct unit_increment
 {
-  std::size_t operator()(const key_t&){ return 1; }
+  template <class K>
+  std::size_t operator()(const K&)const{ return 1; }
 };
 
 
@@ -48,37 +54,111 @@ struct hash_increment{};
 template <> 
 struct hash_increment<short>
 {
-  std::size_t operator()(short x){return (x % 97) + 1;}
+  std::size_t operator()(short x)const{return (x % 97) + 1;}
 };
 
 template <> 
 struct hash_increment<unsigned short>
 {
-  std::size_t operator()(unsigned short x){return (x % 97) + 1;}
+  std::size_t operator()(unsigned short x)const{return (x % 97) + 1;}
 };
 
 template <> 
 struct hash_increment<int>
 {
-  std::size_t operator()(int x){return (x % 97) + 1;}
+  std::size_t operator()(int x)const{return (x % 97) + 1;}
 };
 
 template <> 
 struct hash_increment<unsigned int>
 {
-  std::size_t operator()(unsigned int x){return (x % 97) + 1;}
+  std::size_t operator()(unsigned int x)const{return (x % 97) + 1;}
 };
 
 template <> 
 struct hash_increment<long>
 {
-  std::size_t operator()(long x){return (x % 97) + 1;}
+  std::size_t operator()(long x)const{return (x % 97) + 1;}
 };
 
 template <> 
 struct hash_increment<unsigned long>
 {
-  std::size_t operator()(unsigned long x){return (x % 97) + 1;}
+  std::size_t operator()(unsigned long x)const{return (x % 97) + 1;}
+};
+
+//Strings get a second hash of their own (a different seed), so that keys 
+//with the same home slot do not share the step too. Takes the same key types
+//as hash<std::string>.
+template <> 
+struct hash_increment<std::string>
+{
+  enum {SEED = 97};
+  std::size_t operator()(const std::string& s)const{return step(s.data(), s.size());}
+  std::size_t operator()(const char* s)const{return step(s, std::strlen(s));}
+#ifdef HASHCOL_HAS_STRING_VIEW
+  std::size_t operator()(std::string_view s)const{return step(s.data(), s.size());}
+#endif
+  static std::size_t step(const char* p, std::size_t n){return (hash_bytes(p, n, SEED) % 97) + 1;}
+};
+
+template <> 
+struct hash_increment<const char*>
+{
+  std::size_t operator()(const char* s)const
+  {
+    return hash_increment<std::string>::step(s, std::strlen(s));
+  }
+};
+
+
+//For group probing. Control bytes of 16 slots are scanned at once
+//(with SSE2 when available) and keys are compared only on a tag match. Groups
+//are visited in triangular order, so there is no real increment to compute.
+
+template <class key_t>
+struct group_probing
+{
+  template <class K>
+  std::size_t operator()(const K&)const{ return 1; }
+};
+
+
+//For Robin Hood hashing. Probing is linear, but an insertion takes the slot of
+//any element closer to its home than the new one is, and erasure shifts the
+//following elements back instead of leaving a tombstone.
+
+template <class key_t>
+struct robin_hood_probing
+{
+  template <class K>
+  std::size_t operator()(const K&)const{ return 1; }
+};
+
+
+//Probing categories select the table implementation for an increment_t.
+//Anything unknown is taken as a plain increment function.
+
+struct open_probing_tag{};
+struct group_probing_tag{};
+struct robin_hood_probing_tag{};
+
+template <class increment_t>
+struct probing_traits
+{
+  typedef open_probing_tag category;
+};
+
+template <class key_t>
+struct probing_traits<group_probing<key_t> >
+{
+  typedef group_probing_tag category;
+};
+
+template <class key_t>
+struct probing_traits<robin_hood_probing<key_t> >
+{
+  typedef robin_hood_probing_tag category;
 };
 
 
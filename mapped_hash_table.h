@@ -0,0 +1,223 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef HASHCOL_MAPPED_HASH_TABLE_H
+#define HASHCOL_MAPPED_HASH_TABLE_H
+
+#include <typeinfo>
+#include "hash_table.h"
+#include "snapshot.h"
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+//A read-only view of a snapshot saved by table_t::save() (snapshot.h). 
+//Lookups probe the mapped slots the way table_t does.
+template <class table_t>
+class mapped_hash_table__
+{
+private:
+  typedef typename table_t::Element Element;
+  typedef typename table_t::Probing Probing;
+  typedef typename table_t::growth_policy growth_t;
+
+  //The mapped slots, as hash_table_iterator__ walks them.
+  struct Slots
+  {
+    typedef Element value_type;
+    typedef typename table_t::size_type size_type;
+    typedef typename table_t::difference_type difference_type;
+    enum {WORD_BITS = sizeof(std::size_t) * CHAR_BIT};
+
+    const Element* slots_;
+    const std::size_t* occupied_;
+    size_type size_;
+
+    const Element& operator[](size_type i)const{return this->slots_[i];}
+    size_type size()const{return this->size_;}
+    size_type next_occupied(size_type i)const
+    {
+      if (i >= this->size_) return this->size_;
+      size_type w = i / WORD_BITS;
+      std::size_t word = this->occupied_[w] & (~std::size_t(0) << (i % WORD_BITS));
+      while (word == 0)
+      {
+        if (++w == (this->size_ + WORD_BITS - 1) / WORD_BITS) return this->size_;
+        word = this->occupied_[w];
+      }
+      return w * WORD_BITS + count_trailing_zeros(word);
+    }
+  };
+
+public:
+  typedef typename table_t::key_type key_type;
+  typedef typename table_t::value_type value_type;
+  typedef typename table_t::hasher hasher;
+  typedef typename table_t::incrementer incrementer;
+  typedef typename table_t::key_equal key_equal;
+  typedef typename table_t::get_key get_key;
+  typedef typename table_t::size_type size_type;
+  typedef hash_table_iterator__<Slots, const_traits<value_type> > const_iterator;
+
+  mapped_hash_table__():controls_(0),size_(0)
+  {
+    this->slots_.slots_ = 0;
+    this->slots_.occupied_ = 0;
+    this->slots_.size_ = 0;
+  }
+
+  //Maps the snapshot at path. Fails if it is not one of a table_t. Lookups
+  //use h and eq, which must hash and compare as the saved table's did.
+  bool open(const char* path){return this->open(path, hasher(), key_equal());}
+  bool open(const char* path, const hasher& h){return this->open(path, h, key_equal());}
+  bool open(const char* path, const hasher& h, const key_equal& eq)
+  {
+    this->close();
+    this->hash_ = h;
+    this->key_equals_ = eq;
+    if (!this->file_.open(path)) return false;
+    const snapshot_header* header = this->file_.snapshot(snapshot_layout(typeid(table_t).name()), sizeof(Element));
+    size_type n = header != 0 ? size_type(header->table_size_) : 0;
+    if (header == 0 || n == 0 || header->sizes_[1] != (table_t::grouped(Probing()) ? n : 0) ||
+        header->sizes_[2] != (n + Slots::WORD_BITS - 1) / Slots::WORD_BITS * sizeof(std::size_t))
+    {
+      this->close();
+      return false;
+    }
+    this->slots_.slots_ = reinterpret_cast<const Element*>(this->file_.data() + header->offsets_[0]);
+    this->slots_.occupied_ = reinterpret_cast<const std::size_t*>(this->file_.data() + header->offsets_[2]);
+    this->slots_.size_ = n;
+    this->controls_ = reinterpret_cast<const ctrl_t*>(this->file_.data() + header->offsets_[1]);
+    this->size_ = size_type(header->num_valid_elements_);
+    return true;
+  }
+  void close()
+  {
+    this->file_.close();
+    this->slots_.slots_ = 0;
+    this->slots_.occupied_ = 0;
+    this->slots_.size_ = 0;
+    this->controls_ = 0;
+    this->size_ = 0;
+  }
+  bool is_open()const{return this->file_.data() != 0;}
+
+  //Getters.
+  hasher hash_funct()const{return this->hash_;}
+  key_equal key_eq()const{return this->key_equals_;}
+  //Whether the data matches the checksum it was saved with. Reads it all.
+  bool verify()const
+  {
+    if (!this->is_open()) return false;
+    const snapshot_header* h = reinterpret_cast<const snapshot_header*>(this->file_.data());
+    snapshot_region regions[3];
+    for (std::size_t i = 0; i != 3; ++i)
+    {
+      regions[i].data_ = this->file_.data() + h->offsets_[i];
+      regions[i].size_ = std::size_t(h->sizes_[i]);
+    }
+    regions[0].item_size_ = std::size_t(h->element_size_);
+    return snapshot_checksum(regions, 3) == h->checksum_;
+  }
+
+  const_iterator find(const key_type& k)const
+  {
+    if (!this->is_open()) return this->end();
+    return const_iterator(&this->slots_, this->find_position(k, this->hash_(k), Probing()));
+  }
+  size_type count(const key_type& k)const{return this->find(k) != this->end() ? 1 : 0;}
+
+  size_type size()const{return this->size_;}
+  size_type bucket_count()const{return this->slots_.size_;}
+  bool empty()const{return this->size_ == 0;}
+
+  const_iterator begin()const{return const_iterator(&this->slots_, this->slots_.next_occupied(0));}
+  const_iterator end()const{return const_iterator(&this->slots_, this->slots_.size_);}
+
+private:
+  mapped_file file_;
+  Slots slots_;
+  const ctrl_t* controls_;
+  size_type size_;
+  hasher hash_;
+  incrementer increment_;
+  key_equal key_equals_;
+  get_key get_key_;
+
+  mapped_hash_table__(const mapped_hash_table__&);
+  mapped_hash_table__& operator=(const mapped_hash_table__&);
+
+  //As table_t::find_position().
+  bool holds(const Element& e, const key_type& k, size_type h)const
+  {
+    return e.may_match(h) && this->key_equals_(k, this->get_key_(e.value_));
+  }
+  size_type find_position(const key_type& k, size_type h, open_probing_tag)const
+  {
+    size_type n = this->slots_.size_;
+    size_type step = this->increment_(k);
+    for (size_type hx = growth_t::position(h, n); !this->slots_[hx].is_null(); hx = growth_t::next_position(hx, step, n))
+      if (this->slots_[hx].is_available() && this->holds(this->slots_[hx], k, h)) return hx;
+    return n;
+  }
+  size_type find_position(const key_type& k, size_type h, robin_hood_probing_tag)const
+  {
+    size_type n = this->slots_.size_;
+    size_type hx = growth_t::position(h, n);
+    for (size_type d = 0; ; ++d)
+    {
+      const Element& current = this->slots_[hx];
+      if (current.is_null() || current.probe_distance() < d) return n;
+      if (this->holds(current, k, h)) return hx;
+      hx = growth_t::next_position(hx, 1, n);
+    }
+  }
+  size_type find_position(const key_type& k, size_type h, group_probing_tag)const
+  {
+    size_type num_groups = this->slots_.size_ / control_group::WIDTH;
+    size_type h1;
+    ctrl_t h2;
+    split_group_hash(h, count_trailing_zeros(num_groups), h1, h2);
+    for (group_probe_sequence seq(h1, num_groups); ; seq.next())
+    {
+      control_group group(this->controls_ + seq.offset());
+      for (unsigned m = group.match(h2); m != 0; m &= m - 1)
+      {
+        size_type i = seq.offset() + count_trailing_zeros(m);
+        if (this->holds(this->slots_[i], k, h)) return i;
+      }
+      if (group.match_empty() != 0) return this->slots_.size_;
+    }
+  }
+};
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_MAPPED_HASH_TABLE_H
@@ -0,0 +1,131 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef HASHCOL_PARALLEL_ALGORITHM_H
+#define HASHCOL_PARALLEL_ALGORITHM_H
+
+#include "config.h"
+
+#ifndef HASHCOL_HAS_CXX11
+  #error "parallel_algorithm.h needs C++11 (std::thread)."
+#endif
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "parallel_build.h"
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+/**********************************************************************************
+
+NOTES:
+
+  - Whole table passes on several threads. The slots are cut into many more
+  parts than there are threads (for_each_part() of the containers), and the
+  runner hands the parts out as tasks, so a thread pool works in place of
+  thread_runner (parallel_build.h). Parts are ranges of slots, not of
+  elements: clusters and tombstones may make some slower than others, which
+  is why there are so many of them.
+
+  - The container must not be modified while it is being visited. f may
+  modify the values it is given (not the keys), as each element is visited
+  by one task only.
+
+  - parallel_rehash() rehashes as build() builds: elements are partitioned 
+  by where their probes start and each task moves those of its range of 
+  slots. Growth within insertions stays on the inserting thread; rehashing
+  ahead of a large load avoids most of it.
+
+***********************************************************************************/
+
+//Parts a traversal is cut into.
+const std::size_t PARALLEL_PARTS = 256;
+
+//Calls f on every element of c. Each part gets its own copy of f.
+template <class container_t, class function_t, class runner_t>
+void parallel_for_each(container_t& c, function_t f, runner_t& run)
+{
+  auto task = [&](std::size_t i){c.for_each_part(i, PARALLEL_PARTS, f);};
+  run(PARALLEL_PARTS, task);
+}
+template <class container_t, class function_t>
+void parallel_for_each(container_t& c, function_t f, unsigned nthreads)
+{
+  thread_runner run(nthreads);
+  parallel_for_each(c, f, run);
+}
+
+//Combines map(x) of every element x of c with reduce, which must be 
+//associative and commutative. identity starts every part, so it must leave
+//what it is combined with unchanged (0 for a sum).
+template <class container_t, class T, class map_t, class reduce_t, class runner_t>
+T parallel_reduce(const container_t& c, T identity, map_t map, reduce_t reduce, runner_t& run)
+{
+  struct Part{T value_;};
+  std::vector<Part> parts(PARALLEL_PARTS, Part{identity});
+  auto task = [&](std::size_t i)
+  {
+    T value = identity;
+    c.for_each_part(i, PARALLEL_PARTS, [&](const typename container_t::value_type& x)
+    {
+      value = reduce(std::move(value), map(x));
+    });
+    parts[i].value_ = std::move(value);
+  };
+  run(PARALLEL_PARTS, task);
+  T result = std::move(identity);
+  for (std::size_t i = 0; i != parts.size(); ++i) result = reduce(std::move(result), std::move(parts[i].value_));
+  return result;
+}
+template <class container_t, class T, class map_t, class reduce_t>
+T parallel_reduce(const container_t& c, T identity, map_t map, reduce_t reduce, unsigned nthreads)
+{
+  thread_runner run(nthreads);
+  return parallel_reduce(c, std::move(identity), map, reduce, run);
+}
+
+//c.rehash(n) on several threads.
+template <class container_t, class runner_t>
+void parallel_rehash(container_t& c, typename container_t::size_type n, runner_t& run)
+{
+  c.rehash(n, run);
+}
+template <class container_t>
+void parallel_rehash(container_t& c, typename container_t::size_type n, unsigned nthreads)
+{
+  thread_runner run(nthreads);
+  c.rehash(n, run);
+}
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_PARALLEL_ALGORITHM_H
@@ -0,0 +1,148 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef HASHCOL_PARALLEL_BUILD_H
+#define HASHCOL_PARALLEL_BUILD_H
+
+#include "config.h"
+
+#ifndef HASHCOL_HAS_CXX11
+  #error "parallel_build.h needs C++11 (std::thread)."
+#endif
+
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+/**********************************************************************************
+
+NOTES:
+
+  - Builds a container from a random access range on several threads: keys 
+  are hashed in parallel, partitioned by where their probes start, and each
+  part fills its own range of slots with no locking. The few elements whose
+  probe would run out of their range are inserted at the end, on one thread.
+  The result is the same as inserting the range into an empty container.
+
+  - The work is handed over as tasks to a runner, so containers do not need 
+  threads themselves. thread_runner starts its threads for each step; a 
+  thread pool can take its place with the same call operator.
+
+  - It takes two words per element of extra memory (hash and position) while
+  building. Ranges under a few tens of thousands of elements are simply 
+  inserted.
+
+***********************************************************************************/
+
+//Runs task(0), ..., task(n - 1) on up to threads() threads, each taking the 
+//next task as soon as it is done with one.
+class thread_runner
+{
+public:
+  explicit thread_runner(unsigned threads = std::thread::hardware_concurrency()):
+    threads_(threads == 0 ? 1 : threads){}
+
+  unsigned threads()const{return this->threads_;}
+
+  //If a task throws, no further tasks are started and the first exception is
+  //rethrown here once every thread is joined.
+  template <class task_t>
+  void operator()(std::size_t n, task_t& task)const
+  {
+    std::atomic<std::size_t> next(0);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto work = [&]()
+    {
+      try
+      {
+        for (std::size_t i = next++; i < n; i = next++) task(i);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) error = std::current_exception();
+        next = n;
+      }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(std::min<std::size_t>(this->threads_, n));
+    try
+    {
+      for (unsigned t = 1; t < this->threads_ && t < n; ++t) threads.emplace_back(work);
+    }
+    catch (const std::system_error&)
+    {
+      //Fewer threads; the tasks are still all taken.
+    }
+    work();
+    for (std::size_t t = 0; t != threads.size(); ++t) threads[t].join();
+    if (error) std::rethrow_exception(error);
+  }
+
+private:
+  unsigned threads_;
+};
+
+//Replaces the elements of c with those of [b, e), using nthreads threads.
+template <class container_t, class random_iterator_t>
+void parallel_build(container_t& c, random_iterator_t b, random_iterator_t e, unsigned nthreads)
+{
+  thread_runner run(nthreads);
+  c.build(b, e, run);
+}
+
+template <class container_t, class random_iterator_t>
+container_t parallel_build(random_iterator_t b, random_iterator_t e, unsigned nthreads)
+{
+  container_t c;
+  parallel_build(c, b, e, nthreads);
+  return c;
+}
+
+//c.freeze(), using nthreads threads.
+template <class container_t>
+typename container_t::frozen_type parallel_freeze(const container_t& c, unsigned nthreads)
+{
+  thread_runner run(nthreads);
+  return c.freeze(run);
+}
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_PARALLEL_BUILD_H
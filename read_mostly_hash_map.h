@@ -0,0 +1,226 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef HASHCOL_READ_MOSTLY_HASH_MAP_H
+#define HASHCOL_READ_MOSTLY_HASH_MAP_H
+
+#include "config.h"
+
+#ifndef HASHCOL_HAS_CXX11
+  #error "read_mostly_hash_map.h needs C++11 (std::atomic, thread_local)."
+#endif
+
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <utility>
+
+#include "hash_map.h"
+#include "epoch.h"
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+/**********************************************************************************
+
+NOTES:
+
+  - For maps that are read all the time by many threads and seldom written.
+  Readers take no lock and make no atomic read-modify-write: they announce 
+  an epoch (epoch.h), load the current version of the map and look it up as
+  a hash_map.
+
+  - A write copies the current version, changes the copy and publishes it.
+  So a write costs a copy of the whole map; update() makes any number of 
+  changes under a single copy. Writers are serialized by a mutex.
+
+  - Replaced versions are freed once no reader can still be in them. That is
+  checked after each write, and whatever is still in use waits for the next
+  one (or the destructor).
+
+  - A reader always sees one whole version: read() hands it over, so several
+  lookups can be made against the same state of the map.
+
+***********************************************************************************/
+
+template <
+  class key_t, 
+  class value_t, 
+  class hash_fcn_t = hash<key_t>, 
+  class increment_t = unit_increment<key_t>,
+  class equal_key_t = std::equal_to<key_t>, 
+  class alloc_t = std::allocator<std::pair<key_t, value_t> >,
+  class growth_t = modulo_growth>
+class read_mostly_hash_map 
+{
+private:
+  typedef read_mostly_hash_map<key_t, value_t, hash_fcn_t, increment_t, equal_key_t, alloc_t, growth_t> Self;
+
+public:
+  typedef hash_map<key_t, value_t, hash_fcn_t, increment_t, equal_key_t, alloc_t, growth_t> map_type;
+  typedef typename map_type::key_type key_type;
+  typedef typename map_type::data_type data_type;
+  typedef typename map_type::value_type value_type;
+  typedef typename map_type::size_type size_type;
+  typedef typename map_type::hasher hasher;
+  typedef typename map_type::key_equal key_equal;
+
+  read_mostly_hash_map(size_type max = 100):
+    current_(new map_type(max)){}
+  read_mostly_hash_map(size_type max, const hasher& h, const key_equal& eq = key_equal()):
+    current_(new map_type(max, h, eq)){}
+  //No reader or writer may be left.
+  ~read_mostly_hash_map()
+  {
+    delete this->current_.load();
+    for (std::size_t i = 0; i != this->retired_.size(); ++i) delete this->retired_[i].first;
+  }
+
+  read_mostly_hash_map(const Self&) = delete;
+  Self& operator=(const Self&) = delete;
+
+  //Readers.
+
+  //Calls f(const map_type&) on the current version.
+  template <class function_t>
+  void read(function_t f)const
+  {
+    epoch_domain::guard g;
+    f(*this->current_.load(std::memory_order_acquire));
+  }
+  //Calls f(const value_type&) on the element with key k, if there is one.
+  template <class function_t>
+  bool find(const key_type& k, function_t f)const
+  {
+    epoch_domain::guard g;
+    const map_type& m = *this->current_.load(std::memory_order_acquire);
+    typename map_type::const_iterator it = m.find(k);
+    if (it == m.end()) return false;
+    f(*it);
+    return true;
+  }
+  size_type count(const key_type& k)const
+  {
+    epoch_domain::guard g;
+    return this->current_.load(std::memory_order_acquire)->count(k);
+  }
+  size_type size()const
+  {
+    epoch_domain::guard g;
+    return this->current_.load(std::memory_order_acquire)->size();
+  }
+  bool empty()const{return 0 == this->size();}
+
+  //Writers.
+
+  //Calls f(map_type&) on a copy of the current version, then publishes it.
+  template <class function_t>
+  void update(function_t f)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    map_type* next = new map_type(*this->current_.load(std::memory_order_relaxed));
+    try
+    {
+      f(*next);
+    }
+    catch (...)
+    {
+      delete next;
+      throw;
+    }
+    this->publish(next);
+  }
+  bool insert(const value_type& x)
+  {
+    bool inserted = false;
+    this->update([&](map_type& m){inserted = m.insert(x).second;});
+    return inserted;
+  }
+  //Inserts (k, d), or else assigns d to the element with key k.
+  bool upsert(const key_type& k, const data_type& d)
+  {
+    bool inserted = false;
+    this->update([&](map_type& m){inserted = m.insert_or_assign(k, d).second;});
+    return inserted;
+  }
+  size_type erase(const key_type& k)
+  {
+    size_type erased = 0;
+    this->update([&](map_type& m){erased = m.erase(k);});
+    return erased;
+  }
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    const map_type* current = this->current_.load(std::memory_order_relaxed);
+    //Empty, with the load factor and buckets of the current version, like 
+    //hash_map::clear(); its elements are not copied.
+    map_type* next = new map_type(0, current->hash_funct(), current->key_eq());
+    try
+    {
+      next->max_load_factor(current->max_load_factor());
+      next->rehash(current->bucket_count());
+    }
+    catch (...)
+    {
+      delete next;
+      throw;
+    }
+    this->publish(next);
+  }
+
+private:
+  typedef std::pair<const map_type*, std::size_t> Retired; //Version, epoch.
+
+  //With the writer's mutex held.
+  void publish(map_type* next)
+  {
+    const map_type* old = this->current_.exchange(next);
+    epoch_domain& domain = epoch_domain::instance();
+    this->retired_.push_back(Retired(old, domain.advance()));
+    std::size_t oldest = domain.oldest_reader();
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i != this->retired_.size(); ++i)
+    {
+      if (this->retired_[i].second < oldest) delete this->retired_[i].first;
+      else this->retired_[kept++] = this->retired_[i];
+    }
+    this->retired_.resize(kept);
+  }
+
+  std::atomic<map_type*> current_;
+  std::mutex mutex_;
+  std::vector<Retired> retired_;
+};
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_READ_MOSTLY_HASH_MAP_H
@@ -0,0 +1,262 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef HASHCOL_SNAPSHOT_H
+#define HASHCOL_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include "config.h"
+#include "hash_function.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+  #define HASHCOL_HAS_MMAP
+#endif
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+/**********************************************************************************
+
+NOTES:
+
+  - A snapshot is the image of a table's slots as they are in memory: a
+  header, then the slot array, the control bytes (group probing) and the 
+  bitmap of occupied slots, each starting on a 64 byte boundary. Opening 
+  one maps the file read-only and looks keys up in place, so nothing is 
+  rebuilt or even read before it is needed, and processes that map the same
+  file share its pages.
+
+  - Only tables whose keys and values are trivially copyable can be saved,
+  with a hasher that gives the same values in every process (not seeded 
+  per run). The image depends on the byte order, the word size and the 
+  table type: the header records a fingerprint of the type and the slot 
+  size, and a snapshot is only opened by the same table type. 
+
+  - The slots are written one by one into zeroed chunks, so what is not 
+  part of an element (padding, the values left in empty slots and 
+  tombstones) is written as zeros, not as whatever was in memory.
+
+  - The header has a checksum of its own, checked on opening, and one of the
+  data, which verify() checks: reading it all back would make opening as 
+  slow as loading. The data is hashed in the chunks it is written in.
+
+  - Mapping needs POSIX mmap. Elsewhere snapshots can be saved, but opening 
+  them fails.
+
+***********************************************************************************/
+
+struct snapshot_header
+{
+  enum {VERSION = 2, ALIGNMENT = 64, CHUNK = 1 << 16};
+
+  char magic_[8];
+  hash_word version_;
+  hash_word layout_; //Fingerprint of the table type.
+  hash_word probing_; //0 open addressing, 1 group probing, 2 Robin Hood.
+  hash_word element_size_;
+  hash_word table_size_;
+  hash_word num_elements_; //Tombstones included.
+  hash_word num_valid_elements_;
+  hash_word offsets_[3]; //Slots, control bytes, occupied bitmap.
+  hash_word sizes_[3];
+  hash_word checksum_; //Of the data.
+  hash_word header_checksum_; //Of the fields above.
+
+  std::size_t compute_header_checksum()const
+  {
+    return hash_bytes(this, offsetof(snapshot_header, header_checksum_));
+  }
+};
+
+//Part of the table that goes into the snapshot: items of item_size_ bytes.
+//If there is a copy_ function, items are not written as they are in memory:
+//copy_(data_, i, n, out) writes items [i, i + n) to out, which is zeroed.
+struct snapshot_region
+{
+  const void* data_;
+  std::size_t size_;
+  std::size_t item_size_;
+  void (*copy_)(const void* data, std::size_t first, std::size_t n, unsigned char* out);
+
+  snapshot_region():data_(0),size_(0),item_size_(1),copy_(0){}
+};
+
+//Goes over region r in chunks of whole items of up to CHUNK bytes (one item
+//if they are larger), adding each to checksum c and writing it to f if it 
+//is not null. Returns whether it could be written.
+inline bool snapshot_chunks(const snapshot_region& r, std::vector<unsigned char>& buffer, 
+                            std::size_t& c, std::FILE* f)
+{
+  std::size_t chunk = std::max<std::size_t>(snapshot_header::CHUNK / r.item_size_, 1);
+  std::size_t n = r.size_ / r.item_size_;
+  for (std::size_t i = 0; i < n; i += chunk)
+  {
+    std::size_t bytes = std::min(chunk, n - i) * r.item_size_;
+    const unsigned char* p = static_cast<const unsigned char*>(r.data_) + i * r.item_size_;
+    if (r.copy_ != 0)
+    {
+      buffer.assign(bytes, 0);
+      r.copy_(r.data_, i, bytes / r.item_size_, &buffer[0]);
+      p = &buffer[0];
+    }
+    c = hash_bytes(p, bytes, c);
+    if (f != 0 && std::fwrite(p, 1, bytes, f) != bytes) return false;
+  }
+  return true;
+}
+
+inline std::size_t snapshot_checksum(const snapshot_region* regions, std::size_t n)
+{
+  std::size_t c = 0;
+  std::vector<unsigned char> buffer;
+  for (std::size_t i = 0; i != n; ++i) snapshot_chunks(regions[i], buffer, c, 0);
+  return c;
+}
+
+inline std::size_t snapshot_layout(const char* type_name)
+{
+  return hash_bytes(type_name, std::strlen(type_name));
+}
+
+//Writes header h, whose table fields are set, and the three regions to path.
+inline bool write_snapshot(const char* path, snapshot_header& h, const snapshot_region* regions)
+{
+  std::memcpy(h.magic_, "hashcol", 8);
+  h.version_ = snapshot_header::VERSION;
+  hash_word offset = sizeof(snapshot_header);
+  for (std::size_t i = 0; i != 3; ++i)
+  {
+    offset = (offset + snapshot_header::ALIGNMENT - 1) / snapshot_header::ALIGNMENT * snapshot_header::ALIGNMENT;
+    h.offsets_[i] = offset;
+    h.sizes_[i] = regions[i].size_;
+    offset += regions[i].size_;
+  }
+
+  //The checksum is taken as the data is written; the header is written 
+  //again once it is known.
+  std::FILE* f = std::fopen(path, "wb");
+  if (f == 0) return false;
+  static const char padding[snapshot_header::ALIGNMENT] = {};
+  h.checksum_ = 0;
+  h.header_checksum_ = 0;
+  bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1;
+  hash_word written = sizeof(h);
+  std::size_t c = 0;
+  std::vector<unsigned char> buffer;
+  for (std::size_t i = 0; ok && i != 3; ++i)
+  {
+    std::size_t pad = std::size_t(h.offsets_[i] - written);
+    ok = std::fwrite(padding, 1, pad, f) == pad && snapshot_chunks(regions[i], buffer, c, f);
+    written = h.offsets_[i] + h.sizes_[i];
+  }
+  h.checksum_ = c;
+  h.header_checksum_ = h.compute_header_checksum();
+  ok = ok && std::fseek(f, 0, SEEK_SET) == 0 && std::fwrite(&h, sizeof(h), 1, f) == 1;
+  return std::fclose(f) == 0 && ok;
+}
+
+//A file mapped read-only.
+class mapped_file
+{
+public:
+  mapped_file():data_(0),size_(0){}
+  ~mapped_file(){this->close();}
+
+  bool open(const char* path)
+  {
+    this->close();
+#ifdef HASHCOL_HAS_MMAP
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+      void* p = ::mmap(0, std::size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+      if (p != MAP_FAILED)
+      {
+        this->data_ = static_cast<const unsigned char*>(p);
+        this->size_ = std::size_t(st.st_size);
+      }
+    }
+    ::close(fd);
+#else
+    (void)path;
+#endif
+    return this->data_ != 0;
+  }
+  void close()
+  {
+#ifdef HASHCOL_HAS_MMAP
+    if (this->data_ != 0) ::munmap(const_cast<unsigned char*>(this->data_), this->size_);
+#endif
+    this->data_ = 0;
+    this->size_ = 0;
+  }
+
+  const unsigned char* data()const{return this->data_;}
+  std::size_t size()const{return this->size_;}
+
+  //The header, if the file holds a snapshot of a table with this layout and
+  //element size that is consistent with its size. Null otherwise.
+  const snapshot_header* snapshot(std::size_t layout, std::size_t element_size)const
+  {
+    if (this->size_ < sizeof(snapshot_header)) return 0;
+    const snapshot_header* h = reinterpret_cast<const snapshot_header*>(this->data_);
+    if (std::memcmp(h->magic_, "hashcol", 8) != 0 || h->version_ != snapshot_header::VERSION ||
+        h->header_checksum_ != h->compute_header_checksum() || 
+        h->layout_ != layout || h->element_size_ != element_size ||
+        h->sizes_[0] != h->table_size_ * element_size) 
+      return 0;
+    for (std::size_t i = 0; i != 3; ++i)
+      if (h->offsets_[i] % snapshot_header::ALIGNMENT != 0 || h->offsets_[i] > this->size_ ||
+          h->sizes_[i] > this->size_ - h->offsets_[i])
+        return 0;
+    return h;
+  }
+
+private:
+  const unsigned char* data_;
+  std::size_t size_;
+
+  mapped_file(const mapped_file&);
+  mapped_file& operator=(const mapped_file&);
+};
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_SNAPSHOT_H
@@ -0,0 +1,196 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+//Compares the hash functions and probing strategies of the library on a set 
+//of real keys, one per line (standard input if no file is given). Keys on 
+//even lines are inserted into a hash_set of every configuration; keys on odd
+//lines are looked up as misses (those that are also on even lines are left
+//out). See table_statistics (hash_statistics.h) for what is reported.
+//
+//  hash_analyze [-i] [-l load_factor] [-e n] [file]
+//
+//  -i  keys are integers (long), otherwise they are strings.
+//  -l  load limit of the tables (default: that of the growth policy).
+//  -e  erase every n-th inserted key afterwards, leaving tombstones.
+//
+//Built from this directory with: c++ -O2 -o hash_analyze hash_analyze.cpp
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../hash_set.h"
+
+using namespace hashcol;
+
+
+struct options
+{
+  float load_factor_;
+  std::size_t erase_every_;
+};
+
+//Probe and cluster lengths are given as mean, 99th percentile and maximum.
+void print_header()
+{
+  std::printf("%-36s %9s %5s | %-15s | %-15s | %-15s | %7s %6s\n", 
+              "", "buckets", "load", "hits", "misses", "clusters", "chi2/df", "tomb");
+}
+
+void print_row(const char* name, const table_statistics& s)
+{
+  std::printf("%-36s %9lu %5.2f | %5.2f %4lu %4lu | %5.2f %4lu %4lu | %5.2f %4lu %4lu | %7.3f %6.3f\n",
+              name, 
+              (unsigned long)s.buckets_, s.load_factor(),
+              s.hits_.mean(), (unsigned long)s.hits_.percentile(0.99), (unsigned long)s.hits_.max(),
+              s.misses_.mean(), (unsigned long)s.misses_.percentile(0.99), (unsigned long)s.misses_.max(),
+              s.clusters_.mean(), (unsigned long)s.clusters_.percentile(0.99), (unsigned long)s.clusters_.max(),
+              s.uniformity(), s.tombstone_density());
+}
+
+template <class key_t, class hasher_t, class increment_t, class growth_t>
+void analyze(const std::string& name,
+             const std::vector<key_t>& present, 
+             const std::vector<key_t>& absent,
+             const options& opt)
+{
+  typedef hash_set<key_t, hasher_t, increment_t, std::equal_to<key_t>, std::allocator<key_t>, growth_t> set_t;
+  set_t s(4);
+  if (opt.load_factor_ > 0) s.max_load_factor(opt.load_factor_);
+  for (std::size_t i = 0; i < present.size(); ++i) s.insert(present[i]);
+  if (opt.erase_every_ != 0)
+    for (std::size_t i = 0; i < present.size(); i += opt.erase_every_) s.erase(present[i]);
+  print_row(name.c_str(), s.statistics(absent.begin(), absent.end()));
+}
+
+//Every probing strategy over both growth policies. Double hashing is left out
+//with modulo_growth: its steps may share a factor with the capacity, and the
+//probe sequence then never reaches an empty slot.
+template <class key_t, class hasher_t>
+void analyze_probing(const std::string& hasher_name, 
+                     const std::vector<key_t>& present, 
+                     const std::vector<key_t>& absent,
+                     const options& opt)
+{
+  analyze<key_t, hasher_t, unit_increment<key_t>, modulo_growth>(
+    hasher_name + " linear", present, absent, opt);
+  analyze<key_t, hasher_t, unit_increment<key_t>, power_of_two_growth>(
+    hasher_name + " linear pow2", present, absent, opt);
+  analyze<key_t, hasher_t, hash_increment<key_t>, power_of_two_growth>(
+    hasher_name + " double pow2", present, absent, opt);
+  analyze<key_t, hasher_t, robin_hood_probing<key_t>, modulo_growth>(
+    hasher_name + " robin hood", present, absent, opt);
+  analyze<key_t, hasher_t, robin_hood_probing<key_t>, power_of_two_growth>(
+    hasher_name + " robin hood pow2", present, absent, opt);
+  analyze<key_t, hasher_t, group_probing<key_t>, modulo_growth>(
+    hasher_name + " group", present, absent, opt);
+}
+
+//The hash functions the library provides for each kind of key.
+void analyze_all(const std::vector<long>& present, const std::vector<long>& absent, const options& opt)
+{
+  analyze_probing<long, hash<long> >("hash<long>", present, absent, opt);
+  analyze_probing<long, fmix_hash<long> >("fmix_hash<long>", present, absent, opt);
+  analyze_probing<long, splitmix_hash<long> >("splitmix_hash<long>", present, absent, opt);
+}
+
+void analyze_all(const std::vector<std::string>& present, const std::vector<std::string>& absent, const options& opt)
+{
+  analyze_probing<std::string, hash<std::string> >("hash<string>", present, absent, opt);
+}
+
+template <class key_t>
+void split(const std::vector<key_t>& keys, std::vector<key_t>& present, std::vector<key_t>& absent)
+{
+  hash_set<key_t, hash<key_t>, robin_hood_probing<key_t> > inserted;
+  for (std::size_t i = 0; i < keys.size(); i += 2)
+    if (inserted.insert(keys[i]).second) present.push_back(keys[i]);
+  for (std::size_t i = 1; i < keys.size(); i += 2)
+    if (inserted.find(keys[i]) == inserted.end()) absent.push_back(keys[i]);
+}
+
+bool read_line(std::FILE* in, std::string& line)
+{
+  line.clear();
+  int c;
+  while ((c = std::fgetc(in)) != EOF && c != '\n') line += char(c);
+  if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+  return c != EOF || !line.empty();
+}
+
+int usage()
+{
+  std::fprintf(stderr, "usage: hash_analyze [-i] [-l load_factor] [-e n] [file]\n");
+  return 2;
+}
+
+int main(int argc, char** argv)
+{
+  options opt;
+  opt.load_factor_ = 0;
+  opt.erase_every_ = 0;
+  bool integers = false;
+  const char* file = 0;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "-i") == 0) integers = true;
+    else if (std::strcmp(argv[i], "-l") == 0 && i + 1 < argc) opt.load_factor_ = float(std::atof(argv[++i]));
+    else if (std::strcmp(argv[i], "-e") == 0 && i + 1 < argc) opt.erase_every_ = std::strtoul(argv[++i], 0, 10);
+    else if (argv[i][0] == '-' || file != 0) return usage();
+    else file = argv[i];
+  }
+  if (opt.load_factor_ < 0 || opt.load_factor_ >= 1) return usage();
+
+  std::FILE* in = file != 0 ? std::fopen(file, "r") : stdin;
+  if (in == 0)
+  {
+    std::perror(file);
+    return 1;
+  }
+  std::vector<std::string> lines;
+  std::string line;
+  while (read_line(in, line)) lines.push_back(line);
+  if (in != stdin) std::fclose(in);
+
+  print_header();
+  if (integers)
+  {
+    std::vector<long> keys, present, absent;
+    for (std::size_t i = 0; i < lines.size(); ++i) keys.push_back(std::strtol(lines[i].c_str(), 0, 0));
+    split(keys, present, absent);
+    analyze_all(present, absent, opt);
+  }
+  else
+  {
+    std::vector<std::string> present, absent;
+    split(lines, present, absent);
+    analyze_all(present, absent, opt);
+  }
+  return 0;
+}
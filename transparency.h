@@ -0,0 +1,84 @@
+/*
+* Copyright (c) 2007-2008, Leandro Terra Cunha Melo
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the organization nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY Leandro Terra Cunha Melo "AS IS" AND ANY
+* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL Leandro Terra Cunha Melo BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef HASHCOL_TRANSPARENCY_H
+#define HASHCOL_TRANSPARENCY_H
+
+#include "config.h"
+
+
+HASHCOL_BEGIN_NAMESPACE
+
+
+//Heterogeneous lookup. A hasher or key comparison declaring a nested type
+//is_transparent promises to treat any key-like argument (a const char* or a
+//string_view for a string key, say) as the key it is equal to. When both of
+//a container's do, lookups take such arguments as they are instead of 
+//converting them to key_type first.
+
+template <class function_t>
+struct is_transparent
+{
+private:
+  typedef char Yes;
+  struct No{char c[2];};
+  template <class F> static Yes test(typename F::is_transparent*);
+  template <class F> static No test(...);
+public:
+  enum {value = sizeof(test<function_t>(0)) == sizeof(Yes)};
+};
+
+//result_t for heterogeneous lookups, if they are enabled. K is not used, it
+//only makes the result depend on the lookup's own template parameter, so 
+//that lookups are discarded (SFINAE) rather than ill formed.
+template <bool enabled, class result_t>
+struct enable_lookup{};
+
+template <class result_t>
+struct enable_lookup<true, result_t>
+{
+  typedef result_t type;
+};
+
+template <class hash_fcn_t, class equal_key_t, class K, class result_t>
+struct transparent_lookup : 
+  enable_lookup<is_transparent<hash_fcn_t>::value && is_transparent<equal_key_t>::value, result_t>{};
+
+
+//Transparent key comparison, with operator==.
+
+struct transparent_equal_to
+{
+  typedef void is_transparent;
+  template <class A, class B>
+  bool operator()(const A& a, const B& b)const{return a == b;}
+};
+
+
+HASHCOL_END_NAMESPACE
+
+#endif //HASHCOL_TRANSPARENCY_H